@@ -0,0 +1,261 @@
+/**
+ * \file heap_useNewlib.h
+ * \brief Optional extensions provided by heap_useNewlib_NXP.c and heap_useNewlib_ST.c.
+ *
+ * \par Overview
+ * FreeRTOS's own memory API (pvPortMalloc etc.) is declared by FreeRTOS's portable.h.
+ * This header declares the additional heap_useNewlib functions, each available only
+ * when the corresponding feature is enabled in FreeRTOSConfig.h (see README.md).
+ *
+ * \author Dave Nadler
+ * \date 16-Oct-2026
+ *
+ * \copyright
+ * (c) Dave Nadler 2017-2026, All Rights Reserved.
+ * See heap_useNewlib_NXP.c for license terms.
+ */
+
+#ifndef HEAP_USENEWLIB_H
+#define HEAP_USENEWLIB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#if defined(configHEAP_PRESSURE_LOW_WATERMARK_BYTES)
+  #include "event_groups.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *pvPortCalloc( size_t xNum, size_t xSize ); // as in FreeRTOS 11
+void *pvPortRealloc( void *pv, size_t xSize );
+size_t xPortGetUsableSize( void *pv );
+
+#ifndef configHEAP_CACHE_LINE_SIZE
+  #define configHEAP_CACHE_LINE_SIZE 32 // Cortex-M7 D-cache line
+#endif
+void *pvPortMallocAligned( size_t xAlignment, size_t xSize );
+void *pvPortMallocDma( size_t xSize );
+
+#if (defined(configHEAP_REGION_DMA) && configHEAP_REGION_DMA) || \
+    (defined(configHEAP_REGION_FAST) && configHEAP_REGION_FAST) || \
+    (defined(configHEAP_REGION_BULK) && configHEAP_REGION_BULK) || \
+    (defined(configHEAP_REGION_TRANSIENT) && configHEAP_REGION_TRANSIENT) // DRN memory regions outside newlib's heap
+  #define HEAP_REGIONS
+  typedef enum {
+    eHeapRegionDma,  // __HeapDmaBase..__HeapDmaLimit: MPU region configured non-cacheable
+    eHeapRegionFast, // __HeapFastBase..__HeapFastLimit: DTCM (M7) or SRAM_L (K64F)
+    eHeapRegionBulk, // __HeapBulkBase..__HeapBulkLimit: large slow memory (external SDRAM)
+    eHeapRegionTransient, // __HeapTransientBase..__HeapTransientLimit: short-lived blocks (pvPortMallocLifetime)
+    eHeapRegionCount
+  } eHeapRegion;
+  void *pvPortMallocRegion( eHeapRegion eRegion, size_t xAlignment, size_t xSize ); // free with vPortFree
+  size_t xPortGetRegionFreeSize( eHeapRegion eRegion, size_t *pxMinimumEverFree );
+#endif
+
+#if defined(configHEAP_BUDDY) && configHEAP_BUDDY // DRN buddy allocator (linker provides __HeapBuddyBase, __HeapBuddyLimit)
+  #ifndef configHEAP_BUDDY_MIN_BLOCK
+    #define configHEAP_BUDDY_MIN_BLOCK 256  // power of two, at least 8
+  #endif
+  #ifndef configHEAP_BUDDY_MAX_BLOCK
+    #define configHEAP_BUDDY_MAX_BLOCK 8192 // power of two; region base is aligned to this
+  #endif
+  #define HEAP_BUDDY_ORDERS (__builtin_ctz(configHEAP_BUDDY_MAX_BLOCK) - __builtin_ctz(configHEAP_BUDDY_MIN_BLOCK) + 1)
+  typedef struct {
+    size_t xFreeBytes;
+    size_t xMinimumEverFreeBytes;
+    uint32_t ulAllocations;
+    uint32_t ulFailures;                       // too large, or no free block large enough
+    uint16_t ausFreeBlocks[HEAP_BUDDY_ORDERS]; // [n] counts free blocks of configHEAP_BUDDY_MIN_BLOCK<<n bytes
+  } HeapBuddyStats_t;
+  void *pvPortMallocBuddy( size_t xSize ); // free with vPortFree
+  void vPortGetBuddyStats( HeapBuddyStats_t *pxStats );
+#endif
+
+typedef enum {
+  eHeapPlacementDefault, // newlib's heap
+  eHeapPlacementFast,    // hot data (DSP buffers): fast region
+  eHeapPlacementBulk,    // large, rarely touched data: bulk region
+  eHeapPlacementDma      // DMA buffers: as pvPortMallocDma
+} eHeapPlacement;
+void *pvPortMallocPlaced( size_t xSize, eHeapPlacement ePlacement ); // falls back to newlib's heap
+extern uint32_t HeapPlacementFallbacks; // placed allocations served by newlib's heap because region was full
+
+typedef enum {
+  eHeapLifetimeLong,      // newlib's heap
+  eHeapLifetimePermanent, // never freed: top of heap (configHEAP_LIFETIME)
+  eHeapLifetimeTransient  // freed soon: transient region (configHEAP_REGION_TRANSIENT)
+} eHeapLifetime;
+void *pvPortMallocLifetime( size_t xSize, eHeapLifetime eLifetime ); // falls back to newlib's heap
+#if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME // DRN lifetime-segregated allocation (requires malloc wrappers)
+  eHeapLifetime xPortHeapSetLifetime( eHeapLifetime eLifetime ); // hint for calling task's malloc calls
+  size_t xPortGetPermanentHeapUsage( void );
+#endif
+
+#if defined(configHEAP_RESERVE_BYTES) && configHEAP_RESERVE_BYTES // DRN emergency reserve
+  void *pvPortMallocCritical( size_t xSize );
+  void vApplicationHeapReserveHook( void ); // application provides this
+#endif
+
+#if defined(configHEAP_ARENA) && configHEAP_ARENA // DRN arena allocator
+  typedef struct HeapArenaChunk {
+    struct HeapArenaChunk *pxNext;
+    uint8_t *pucLimit;           // first byte beyond chunk
+  } HeapArenaChunk_t;            // header at start of each chunk
+  typedef struct {
+    uint8_t *pucNext;            // next free byte in current chunk
+    uint8_t *pucLimit;           // first byte beyond current chunk
+    HeapArenaChunk_t *pxCurrent;
+    HeapArenaChunk_t *pxFirst;   // chunks in order of use
+    void *pvStaticBuffer;        // first chunk, if provided by application (never freed)
+    size_t xChunkSize;           // size of chunks allocated when the arena grows; 0: never grow
+  } HeapArena_t;
+  void vPortArenaInit( HeapArena_t *pxArena, void *pvBuffer, size_t xBufferSize, size_t xChunkSize );
+  void *pvPortArenaAlloc( HeapArena_t *pxArena, size_t xSize );
+  void *pvPortArenaAllocAligned( HeapArena_t *pxArena, size_t xAlignment, size_t xSize );
+  void vPortArenaReset( HeapArena_t *pxArena );   // O(1): frees every block, keeps chunks
+  void vPortArenaDestroy( HeapArena_t *pxArena ); // returns chunks to heap
+#endif
+
+#if defined(configHEAP_MOVABLE_BYTES) && configHEAP_MOVABLE_BYTES // DRN relocatable blocks, compacted when idle
+  typedef struct HeapMovable *HeapHandle_t;
+  HeapHandle_t xPortMallocMovable( size_t xSize );
+  void vPortFreeMovable( HeapHandle_t xHandle );
+  void *pvPortLockMovable( HeapHandle_t xHandle );   // pin block and get its address
+  void vPortUnlockMovable( HeapHandle_t xHandle );   // block may move again
+  size_t xPortGetMovableSize( HeapHandle_t xHandle );
+  void vPortHeapCompactFromIdleHook( void );
+  size_t xPortGetMovableFreeSize( size_t *pxLargestFree );
+#endif
+
+#if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE // DRN caches of freed kernel objects
+  typedef struct {
+    size_t xObjectSize;    // allocation size served (sizeof(StaticQueue_t) etc.)
+    UBaseType_t uxCached;  // freed blocks held now
+    size_t xCachedBytes;   // their size (counted as free by xPortGetFreeHeapSize)
+    uint32_t ulHits;       // allocations served from the cache
+    uint32_t ulMisses;     // allocations that went to newlib
+    uint32_t ulTrimmed;    // blocks returned to newlib
+  } HeapObjectCacheStats_t;
+  void vPortObjectCacheTrimFromIdleHook( void );
+  void vPortObjectCacheFlush( void ); // return all cached blocks to newlib
+  BaseType_t xPortObjectCachePrefill( size_t xSize, UBaseType_t uxCount );
+  UBaseType_t uxPortGetObjectCacheStats( HeapObjectCacheStats_t *pxStats, UBaseType_t uxMaxCaches );
+#endif
+
+#if defined(configHEAP_BOOT_ARENA) && configHEAP_BOOT_ARENA // DRN boot-time arena
+  size_t xPortGetBootArenaUsage( size_t *pxArenaSize );
+#endif
+
+#if (defined(configHEAP_BOOT_RECORD) && configHEAP_BOOT_RECORD) || (defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN)
+  void vPortHeapBootComplete( void ); // DRN record-and-freeze: end of boot allocations
+#endif
+#if defined(configHEAP_BOOT_RECORD) && configHEAP_BOOT_RECORD // DRN record boot allocations
+  void vPortHeapBootRecordDump( void (*pfnOutput)( const char *pcLine ) );
+#endif
+#if defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN // DRN serve boot allocations from generated storage
+  typedef struct {
+    uint32_t size;   // requested
+    uint32_t align;  // 0: default alignment
+  } HeapFrozenBlock_t;
+  // Provided by the source file generated from vPortHeapBootRecordDump's output (see README.md)
+  extern const HeapFrozenBlock_t xHeapFrozenBlocks[]; // in boot allocation order
+  extern const uint32_t xHeapFrozenBlockCount;
+  extern uint64_t ullHeapFrozenStorage[];
+  extern const size_t xHeapFrozenStorageSize;
+  extern uint32_t HeapFrozenBlocksServed; // boot allocations served from frozen storage
+#endif
+
+#if defined(configHEAP_PRESSURE_LOW_WATERMARK_BYTES) // DRN heap pressure notification
+  BaseType_t xPortHeapPressureAddListener( TaskHandle_t xTask, uint32_t ulNotifyBits );
+  void vPortHeapPressureRemoveListener( TaskHandle_t xTask );
+  void vPortHeapPressureSetEventGroup( EventGroupHandle_t xEventGroup, EventBits_t uxBits );
+  BaseType_t xPortIsHeapUnderPressure( void );
+#endif
+
+#if defined(configHEAP_TRIM_IDLE_INTERVAL_TICKS) // DRN return unused top of heap after bursts
+  void vPortHeapTrimFromIdleHook( void );
+#endif
+
+#if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING // DRN per-task heap accounting and quotas
+  void vPortSetTaskHeapQuota( TaskHandle_t xTask, size_t xQuotaBytes );
+  size_t xPortGetTaskHeapUsage( TaskHandle_t xTask, size_t *pxPeakBytes, uint32_t *pulQuotaFailures );
+#endif
+
+#if defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS // DRN leak detector (debug)
+  void vPortHeapLeakDump( TaskHandle_t xTask, void (*pfnOutput)( const char *pcLine ) );
+  extern uint32_t HeapLeakTableOverflows; // blocks not tracked because table was full
+  #if defined(configHEAP_LEAK_DETECTOR_HOOK) && configHEAP_LEAK_DETECTOR_HOOK
+    void vApplicationHeapLeakHook( TaskHandle_t xTask, uint32_t ulBlocks, size_t xBytes ); // application provides this
+  #endif
+#endif
+
+#if defined(configHEAP_FRAG_ANALYZER_CHUNKS_PER_SLICE) && configHEAP_FRAG_ANALYZER_CHUNKS_PER_SLICE // DRN fragmentation analyzer
+  #define HEAP_FRAG_HISTOGRAM_BUCKETS 16
+  typedef struct {
+    uint32_t ulWalksCompleted;
+    uint32_t ulWalksRestarted;      // heap changed during walk
+    uint32_t ulUsedChunks;
+    uint32_t ulFreeChunks;
+    size_t xUsedBytes;              // in used chunks, including newlib's overhead
+    size_t xFreeBytes;              // in free chunks, plus heap not yet provided to newlib
+    size_t xLargestFreeBlock;       // largest contiguous free area (including top of heap)
+    uint16_t usFragmentationPermille; // 1000*(1-largest/free); 0 when all free memory is contiguous
+    uint16_t ausFreeChunkHistogram[HEAP_FRAG_HISTOGRAM_BUCKETS]; // [n] counts free chunks of 2^(n+4) to 2^(n+5)-1 bytes
+                                                                 // (first and last buckets also count smaller and larger)
+  } HeapFragStats_t;
+  void vPortHeapFragAnalyzeFromIdleHook( void );
+  BaseType_t xPortGetHeapFragStats( HeapFragStats_t *pxStats );
+  #if defined(configHEAP_FRAG_ANALYZER_MAP_RUNS) && configHEAP_FRAG_ANALYZER_MAP_RUNS
+    void vPortHeapMapDump( void (*pfnOutput)( const char *pcLine ) );
+  #endif
+#endif
+
+#if defined(configHEAP_CHECK_CHUNKS_PER_SLICE) && configHEAP_CHECK_CHUNKS_PER_SLICE // DRN heap integrity checker
+  void vPortHeapCheckFromIdleHook( void );
+  extern uint32_t HeapCheckPasses;   // complete passes without finding damage
+  extern uint32_t HeapCheckRestarts; // passes abandoned because heap changed
+#endif
+
+#if defined(configHEAP_ALLOC_STATS) && configHEAP_ALLOC_STATS // DRN allocation statistics
+  void vPortHeapAllocStatsReset( void );
+  size_t xPortHeapAllocStatsExport( uint8_t *pucBuffer, size_t xBufferSize );
+#endif
+
+#if defined(configHEAP_LATENCY_STATS) && configHEAP_LATENCY_STATS // DRN heap operation latency
+  typedef enum { eHeapOpPvPortMalloc, eHeapOpVPortFree, eHeapOpMalloc, eHeapOpFree, eHeapOpRealloc,
+                 eHeapOpPvPortMallocBuddy, eHeapOpCount } eHeapLatencyOp;
+  #define HEAP_LATENCY_BUCKETS 24 // [n] counts operations taking 2^n to 2^(n+1)-1 cycles (last also longer)
+  typedef struct {
+    uint32_t ulCount;
+    uint32_t ulMaxCycles;
+    void *pvMaxCaller;           // caller of the slowest operation
+    uint64_t ullTotalCycles;
+    uint64_t ullLockCycles;      // part of total spent taking and releasing heap locks; rest is allocator work
+    uint32_t aulHistogram[HEAP_LATENCY_BUCKETS];
+  } HeapLatencyStats_t;
+  void vPortHeapLatencySnapshot( HeapLatencyStats_t pxStats[eHeapOpCount], BaseType_t xReset );
+#endif
+
+#if defined(configHEAP_EXCEPTION_POOL_BLOCKS) && configHEAP_EXCEPTION_POOL_BLOCKS // DRN exception object pool (heap_useNewlib_cxa.cpp)
+  extern uint32_t HeapExceptionPoolMisses; // exceptions allocated from the heap because the pool couldn't serve them
+#endif
+
+#if (defined(configHEAP_CHECK_CHUNKS_PER_SLICE) && configHEAP_CHECK_CHUNKS_PER_SLICE) || \
+    (defined(configHEAP_REDZONE) && configHEAP_REDZONE)
+  void vApplicationHeapCorruptHook( void *pvAddress ); // application provides this
+#endif
+
+#if (defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING) || \
+    (defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS)
+  void vPortHeapTaskDeleted( void *xTask ); // void* so it can be declared in FreeRTOSConfig.h for traceTASK_DELETE
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEAP_USENEWLIB_H
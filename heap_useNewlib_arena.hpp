@@ -0,0 +1,76 @@
+/**
+ * \file heap_useNewlib_arena.hpp
+ * \brief C++ front-end for the heap_useNewlib arena allocator (configHEAP_ARENA).
+ *
+ * \par Overview
+ * freertos_arena owns a HeapArena_t: request-scoped objects are created in the arena with a
+ * bump pointer and no heap lock, then released all at once by reset() or the destructor.
+ * Only trivially destructible types may be created, as the arena never runs destructors.
+ * Use handle() to pass the arena to C code using the pvPortArena... functions.
+ * (For std::pmr containers, see freertos_arena_resource in heap_useNewlib_pmr.hpp.)
+ *
+ * \par Example
+ *     static uint8_t scratch[2048];
+ *     freertos_arena arena{scratch, sizeof(scratch), 1024}; // grows in 1KB chunks when full
+ *     for(;;) {
+ *       Field *fields = arena.create_array<Field>(count);  // nullptr if out of memory
+ *       ...
+ *       arena.reset();                                     // O(1), chunks kept for next request
+ *     }
+ *
+ * \author Dave Nadler
+ * \date 16-Oct-2026
+ *
+ * \copyright
+ * (c) Dave Nadler 2017-2026, All Rights Reserved.
+ * See heap_useNewlib_NXP.c for license terms.
+ */
+
+#ifndef HEAP_USENEWLIB_ARENA_HPP
+#define HEAP_USENEWLIB_ARENA_HPP
+
+#include <new>
+#include <type_traits>
+#include <utility> // forward
+
+#include "FreeRTOS.h"
+#include "heap_useNewlib.h"
+
+#if !(defined(configHEAP_ARENA) && configHEAP_ARENA)
+  #error "heap_useNewlib_arena.hpp requires #define configHEAP_ARENA 1 in FreeRTOSConfig.h"
+#endif
+
+//! Arena allocator for one task (not thread-safe); see file overview.
+class freertos_arena {
+public:
+  //! Arena whose chunks all come from the FreeRTOS heap.
+  explicit freertos_arena(size_t chunk_size) { vPortArenaInit(&arena, nullptr, 0, chunk_size); }
+  //! Arena starting in buffer; then grows from the heap in chunk_size chunks (0: never grows).
+  freertos_arena(void *buffer, size_t size, size_t chunk_size = 0) { vPortArenaInit(&arena, buffer, size, chunk_size); }
+  ~freertos_arena() { vPortArenaDestroy(&arena); }
+  freertos_arena(const freertos_arena &) = delete;
+  freertos_arena &operator=(const freertos_arena &) = delete;
+
+  void *allocate(size_t bytes, size_t alignment = 0) noexcept { return pvPortArenaAllocAligned(&arena, alignment, bytes); }
+  //! Construct a T in the arena; nullptr if the arena is full.
+  template<class T, class... Args> T *create(Args &&... args) {
+    static_assert(std::is_trivially_destructible<T>::value, "arena never runs destructors");
+    void *p = allocate(sizeof(T), alignof(T));
+    return p ? new(p) T(std::forward<Args>(args)...) : nullptr;
+  }
+  //! Default-construct count T's in the arena; nullptr if the arena is full.
+  template<class T> T *create_array(size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value, "arena never runs destructors");
+    if(count > SIZE_MAX / sizeof(T)) return nullptr;
+    T *p = static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+    if(p) for(size_t i = 0; i < count; i++) new(p + i) T();
+    return p;
+  }
+  void reset() noexcept { vPortArenaReset(&arena); }     // release everything, keep chunks
+  void release() noexcept { vPortArenaDestroy(&arena); } // release everything, return chunks to heap
+  HeapArena_t *handle() noexcept { return &arena; }
+private:
+  HeapArena_t arena;
+};
+
+#endif // HEAP_USENEWLIB_ARENA_HPP
@@ -0,0 +1,2690 @@
+/**
+ * \file heap_useNewlib_core.h
+ * \brief Board-independent core of heap_useNewlib: wrappers required to use newlib malloc-family within FreeRTOS.
+ *
+ * \par Overview
+ * Included once, by the board file (heap_useNewlib_NXP.c or heap_useNewlib_ST.c), after it
+ * defines the board profile (HEAP_BOARD_... macros, below). Don't compile this file separately.
+ * See heap_useNewlib_NXP.c for a description of the wrappers and their revision history.
+ *
+ * \author Dave Nadler
+ * \date 16-Oct-2026
+ *
+ * \copyright
+ * (c) Dave Nadler 2017-2026, All Rights Reserved.
+ * See heap_useNewlib_NXP.c for license terms.
+ */
+
+#ifdef HEAP_USENEWLIB_CORE_H
+  #error "heap_useNewlib_core.h must be included only once, by the board file"
+#endif
+#define HEAP_USENEWLIB_CORE_H
+
+#include <stdlib.h> // maps to newlib...
+#include <malloc.h> // mallinfo...
+#include <errno.h>  // ENOMEM
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h> // memcpy
+#include <stdio.h>  // snprintf
+
+#include "newlib.h"
+#if ((__NEWLIB__ == 2) && (__NEWLIB_MINOR__ < 5)) || ((__NEWLIB__ == 4) && (__NEWLIB_MINOR__ > 2) || (__NEWLIB__ < 2) || (__NEWLIB__ > 4))
+  #warning "This wrapper was verified for newlib versions 2.5 - 4.2; please ensure newlib's external requirements for malloc-family are unchanged!"
+#endif
+
+#include "FreeRTOS.h" // defines public interface we're implementing here
+#if !defined(configUSE_NEWLIB_REENTRANT) ||  (configUSE_NEWLIB_REENTRANT!=1)
+  #warning "#define configUSE_NEWLIB_REENTRANT 1 // Required for thread-safety of newlib sprintf, dtoa, strtok, etc..."
+  // If you're *REALLY* sure you don't need FreeRTOS's newlib reentrancy support, comment out the above warning...
+#endif
+#include "task.h"
+#include "heap_useNewlib.h" // optional extensions implemented here
+
+// ================================================================================================
+// External routines required by newlib's malloc (sbrk/_sbrk, __malloc_lock/unlock)
+// ================================================================================================
+
+// Simplistic sbrk implementations assume stack grows downwards from top of memory,
+// and heap grows upwards starting just after BSS.
+// FreeRTOS normally allocates task stacks from a pool placed within BSS or DATA.
+// Thus within a FreeRTOS task, stack pointer is always below end of BSS.
+// When using this module, stacks are allocated from malloc pool, still always prior
+// current unused heap area...
+
+// Heap bounds come from the board profile (see heap_useNewlib_NXP.c or heap_useNewlib_ST.c).
+// Bounds are bound to the board's linker symbols by name, so they're link-time constants:
+// _sbrk_r needs no run-time initialization, and no per-board tests.
+#ifndef HEAP_BOARD_BASE_SYMBOL
+  #define HEAP_BOARD_BASE_SYMBOL "__HeapBase"   // linker symbol: first byte of heap
+#endif
+#ifndef HEAP_BOARD_LIMIT_SYMBOL
+  #define HEAP_BOARD_LIMIT_SYMBOL "__HeapLimit" // linker symbol: first byte beyond heap (and ISR stack)
+#endif
+#ifndef HEAP_BOARD_ISR_STACK_BYTES
+  #define HEAP_BOARD_ISR_STACK_BYTES 0          // bytes below limit symbol reserved for ISR (MSP) stack
+#endif
+#ifndef HEAP_BOARD_SP_LIMIT_BEFORE_SCHEDULER
+  #define HEAP_BOARD_SP_LIMIT_BEFORE_SCHEDULER 0 // 1: until scheduler starts, heap may not grow past stack pointer
+#endif
+extern char __HeapBase  __asm(HEAP_BOARD_BASE_SYMBOL);  // symbols from linker LD command file
+extern char __HeapLimit __asm(HEAP_BOARD_LIMIT_SYMBOL);
+#define heapLimit (&__HeapLimit - HEAP_BOARD_ISR_STACK_BYTES) // first byte beyond heap
+#if HEAP_BOARD_SP_LIMIT_BEFORE_SCHEDULER
+  register char * stack_ptr asm("sp");
+#endif
+
+uint32_t TotalHeapSize; // publish for diagnostic routines (set before main, not by _sbrk_r)
+__attribute__((constructor)) static void heapPublishTotalSize(void) {
+    TotalHeapSize = (uint32_t)(heapLimit - &__HeapBase);
+}
+
+#ifdef MALLOCS_INSIDE_ISRs // STM code to avoid malloc within ISR (USB CDC stack)
+    // We can't use vTaskSuspendAll() within an ISR.
+    // STM's stunningly bad coding malpractice calls malloc within ISRs (for example, on USB connect function USBD_CDC_Init)
+    // So, we must just suspend/resume interrupts, lengthening max interrupt response time, aarrggg...
+    #define DRN_ENTER_CRITICAL_SECTION(_usis) { _usis = taskENTER_CRITICAL_FROM_ISR(); } // Disables interrupts (after saving prior state)
+    #define DRN_EXIT_CRITICAL_SECTION(_usis)  { taskEXIT_CRITICAL_FROM_ISR(_usis);     } // Re-enables interrupts (unless already disabled prior taskENTER_CRITICAL)
+#else
+    #define DRN_ENTER_CRITICAL_SECTION(_usis) vTaskSuspendAll(); // Note: safe to use before FreeRTOS scheduler started, but not in ISR
+    #define DRN_EXIT_CRITICAL_SECTION(_usis)  xTaskResumeAll();  // Note: safe to use before FreeRTOS scheduler started, but not in ISR
+#endif
+
+#ifndef NDEBUG
+    static int totalBytesProvidedBySBRK = 0;
+#endif
+
+#if defined(configHEAP_RESERVE_BYTES) && configHEAP_RESERVE_BYTES // DRN emergency reserve
+    // The top configHEAP_RESERVE_BYTES of the heap are withheld from normal allocations, so that
+    // critical paths (fault logging, orderly shutdown) can still allocate once the heap is exhausted.
+    // Reserve is available to allocations made via pvPortMallocCritical, and (unless
+    // configHEAP_RESERVE_AUTO_RELEASE is 0) is released to everyone when a normal allocation would fail.
+    // Note: once sbrk hands reserve memory to newlib, freed blocks return to newlib's common pool.
+    #ifndef configHEAP_RESERVE_AUTO_RELEASE
+      #define configHEAP_RESERVE_AUTO_RELEASE 1
+    #endif
+    static bool heapReserveReleased;     // reserve now available to all allocations
+    static bool heapReserveHookCalled;   // application already told we're living on the reserve
+    static bool heapCriticalAllocation;  // set by pvPortMallocCritical while its malloc runs
+    //! Called once (with scheduler suspended, so must not block) when reserve memory is first used.
+    //! Application should shed load (flush logs, drop connections, etc.)
+    extern void vApplicationHeapReserveHook( void );
+#endif
+
+// newlib may call _sbrk_r() with a negative 'incr' to return free memory at the top of the heap
+// (malloc_trim, or free of a large top chunk); returned memory is again available to sbrk.
+// Use of vTaskSuspendAll() in _sbrk_r() is normally redundant, as newlib malloc family routines call
+// __malloc_lock before calling _sbrk_r(). Note vTaskSuspendAll/xTaskResumeAll support nesting.
+
+static char *currentHeapEnd = &__HeapBase; // first byte not yet handed to newlib by sbrk
+#if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME // DRN lifetime-segregated allocation
+  // Permanent blocks are bump-allocated downward from the top of the heap, so newlib's heap ends below them.
+  static char *heapPermanentFloor = heapLimit; // lowest permanent block's header
+  #define heapSbrkLimit heapPermanentFloor
+#else
+  #define heapSbrkLimit heapLimit
+#endif
+
+//! _sbrk_r version supporting reentrant newlib (depends upon above symbols defined by linker control file).
+void * _sbrk_r(struct _reent *pReent, int incr) {
+	(void)pReent;
+    #ifdef MALLOCS_INSIDE_ISRs // block interrupts during free-storage use
+      UBaseType_t usis; // saved interrupt status
+    #endif
+    #if HEAP_BOARD_SP_LIMIT_BEFORE_SCHEDULER
+      char* limit = (xTaskGetSchedulerState()==taskSCHEDULER_NOT_STARTED && stack_ptr < heapSbrkLimit) ?
+            stack_ptr   :  // Before scheduler is started, limit is stack pointer (risky!), if below permanent blocks
+            heapSbrkLimit; // Once running, OK to reuse all remaining RAM except ISR stack (MSP) stack
+    #else
+      char *limit = heapSbrkLimit;
+    #endif
+    DRN_ENTER_CRITICAL_SECTION(usis);
+    #if defined(configHEAP_RESERVE_BYTES) && configHEAP_RESERVE_BYTES // DRN emergency reserve
+      bool callReserveHook = false;
+      if (incr > 0 && !heapReserveReleased && (currentHeapEnd + incr > limit - configHEAP_RESERVE_BYTES)) {
+        // This request needs the reserve. Critical allocations always get it; others only if auto-release
+        // is configured and the reserve is actually sufficient (otherwise keep it for critical paths).
+        if (!heapCriticalAllocation) {
+          if (configHEAP_RESERVE_AUTO_RELEASE && (currentHeapEnd + incr <= limit)) {
+            heapReserveReleased = true;
+          } else {
+            limit -= configHEAP_RESERVE_BYTES; // normal heap exhausted, fail below
+          }
+        }
+        if (!heapReserveHookCalled && (currentHeapEnd + incr <= limit)) {
+          heapReserveHookCalled = callReserveHook = true;
+        }
+      }
+    #endif
+    if (currentHeapEnd + incr < &__HeapBase) {
+        // Negative 'incr' (newlib trimming top of heap) may not release more than was provided.
+        pReent->_errno = EINVAL; // newlib's thread-specific errno
+        DRN_EXIT_CRITICAL_SECTION(usis);
+        return (char *)-1;
+    }
+    if (currentHeapEnd + incr > limit) {
+        // Ooops, no more memory available...
+        #if( configUSE_MALLOC_FAILED_HOOK == 1 )
+          {
+            extern void vApplicationMallocFailedHook( void );
+            DRN_EXIT_CRITICAL_SECTION(usis);
+            vApplicationMallocFailedHook();
+          }
+        #elif defined(configHARD_STOP_ON_MALLOC_FAILURE)
+            // If you want to alert debugger or halt...
+            // WARNING: brkpt instruction may prevent watchdog operation...
+            while(1) { __asm("bkpt #0"); } // Stop in GUI as if at a breakpoint (if debugging, otherwise loop forever)
+        #else
+            // Default, if you prefer to believe your application will gracefully trap out-of-memory...
+            pReent->_errno = ENOMEM; // newlib's thread-specific errno
+            DRN_EXIT_CRITICAL_SECTION(usis);
+        #endif
+        return (char *)-1; // the malloc-family routine that called sbrk will return 0
+    }
+    // 'incr' of memory is available: update accounting and return it.
+    char *previousHeapEnd = currentHeapEnd;
+    currentHeapEnd += incr;
+    #ifndef NDEBUG
+        totalBytesProvidedBySBRK += incr;
+    #endif
+    #if defined(configHEAP_RESERVE_BYTES) && configHEAP_RESERVE_BYTES // DRN emergency reserve
+      // If trimming has returned the reserve, re-arm it (and its hook) for the next emergency.
+      if (incr < 0 && heapReserveReleased && (currentHeapEnd <= limit - configHEAP_RESERVE_BYTES)) {
+        heapReserveReleased = heapReserveHookCalled = false;
+      }
+    #endif
+    DRN_EXIT_CRITICAL_SECTION(usis);
+    #if defined(configHEAP_RESERVE_BYTES) && configHEAP_RESERVE_BYTES // DRN emergency reserve
+      if (callReserveHook) vApplicationHeapReserveHook();
+    #endif
+    return (char *) previousHeapEnd;
+}
+//! non-reentrant sbrk uses is actually reentrant by using current context
+// ... because the current _reent structure is pointed to by global _impure_ptr
+char * sbrk(int incr) { return _sbrk_r(_impure_ptr, incr); }
+//! _sbrk is a synonym for sbrk.
+char * _sbrk(int incr) { return sbrk(incr); }
+
+//! Heap not yet handed to newlib by sbrk, and available to normal allocations.
+static size_t heapBytesAvailableFromSbrk(void) {
+    int notYetSbrkd = (int)(heapSbrkLimit - currentHeapEnd);
+    #if defined(configHEAP_RESERVE_BYTES) && configHEAP_RESERVE_BYTES // DRN emergency reserve
+      if (!heapReserveReleased) { // unused reserve isn't available to normal allocations
+        notYetSbrkd = (notYetSbrkd > configHEAP_RESERVE_BYTES) ? notYetSbrkd-configHEAP_RESERVE_BYTES : 0;
+      }
+    #endif
+    return (notYetSbrkd > 0) ? (size_t)notYetSbrkd : 0;
+}
+
+#if defined(configHEAP_TRIM_IDLE_INTERVAL_TICKS) // DRN return unused top of heap after bursts
+  #ifndef configHEAP_TRIM_PAD_BYTES
+    #define configHEAP_TRIM_PAD_BYTES 0 // free bytes newlib should keep at top of heap
+  #endif
+  //! Call from vApplicationIdleHook. If newlib's heap has grown since the last trim, at most once
+  //! per configHEAP_TRIM_IDLE_INTERVAL_TICKS release free memory at its top via malloc_trim, so the
+  //! footprint shrinks once a burst subsides. Note newlib-nano's malloc_trim does nothing.
+  void vPortHeapTrimFromIdleHook( void ) {
+    static TickType_t lastTrimTick;
+    static char *heapEndAfterTrim = &__HeapBase;
+    TickType_t now = xTaskGetTickCount();
+    if(currentHeapEnd <= heapEndAfterTrim) return; // no growth (cheap check without malloc lock)
+    if((TickType_t)(now-lastTrimTick) < (TickType_t)(configHEAP_TRIM_IDLE_INTERVAL_TICKS)) return;
+    lastTrimTick = now;
+    (void)malloc_trim(configHEAP_TRIM_PAD_BYTES);
+    heapEndAfterTrim = currentHeapEnd;
+  }
+#endif
+
+#ifdef MALLOCS_INSIDE_ISRs // block interrupts during free-storage use
+  static UBaseType_t malLock_uxSavedInterruptStatus;
+#endif
+#if defined(configHEAP_LATENCY_STATS) && configHEAP_LATENCY_STATS // DRN heap operation latency
+  #ifndef configHEAP_LATENCY_CYCLES
+    #define configHEAP_LATENCY_CYCLES() (*(volatile uint32_t *)0xE0001004UL) // Cortex-M3/4/7 DWT->CYCCNT
+  #endif
+  static uint32_t heapLockCycles; // total spent taking and releasing heap locks (including any task switch on release)
+  #define HEAP_LOCK_TIMING_BEGIN() uint32_t lockStart = configHEAP_LATENCY_CYCLES()
+  #define HEAP_LOCK_TIMING_END()   (void)__atomic_fetch_add(&heapLockCycles, configHEAP_LATENCY_CYCLES()-lockStart, __ATOMIC_RELAXED)
+#else
+  #define HEAP_LOCK_TIMING_BEGIN()
+  #define HEAP_LOCK_TIMING_END()
+#endif
+static uint32_t heapMallocLockCount; // newlib may have changed the heap if this changes
+void __malloc_lock(struct _reent *r)   {
+  (void)(r);
+  HEAP_LOCK_TIMING_BEGIN();
+  #if defined(MALLOCS_INSIDE_ISRs)
+    DRN_ENTER_CRITICAL_SECTION(malLock_uxSavedInterruptStatus);
+  #else
+    bool insideAnISR = xPortIsInsideInterrupt();
+    configASSERT( !insideAnISR ); // Make damn sure no more mallocs inside ISRs!!
+  vTaskSuspendAll();
+  #endif
+  heapMallocLockCount++;
+  HEAP_LOCK_TIMING_END();
+}
+void __malloc_unlock(struct _reent *r) {
+  (void)(r);
+  HEAP_LOCK_TIMING_BEGIN();
+  #if defined(MALLOCS_INSIDE_ISRs)
+    DRN_EXIT_CRITICAL_SECTION(malLock_uxSavedInterruptStatus);
+  #else
+  (void)xTaskResumeAll();
+  #endif
+  HEAP_LOCK_TIMING_END();
+}
+
+// Malloc wrappers (below) hold this lock across the wrapped call, so their accounting isn't disturbed
+// by other tasks. Unlike __malloc_lock, these nest properly in MALLOCS_INSIDE_ISRs mode.
+static UBaseType_t heapWrapLock(void) {
+  HEAP_LOCK_TIMING_BEGIN();
+  #if defined(MALLOCS_INSIDE_ISRs)
+    UBaseType_t usis = taskENTER_CRITICAL_FROM_ISR();
+  #else
+    vTaskSuspendAll();
+    UBaseType_t usis = 0;
+  #endif
+  HEAP_LOCK_TIMING_END();
+  return usis;
+}
+static void heapWrapUnlock(UBaseType_t usis) {
+  HEAP_LOCK_TIMING_BEGIN();
+  #if defined(MALLOCS_INSIDE_ISRs)
+    taskEXIT_CRITICAL_FROM_ISR(usis);
+  #else
+    (void)usis;
+    (void)xTaskResumeAll();
+  #endif
+  HEAP_LOCK_TIMING_END();
+}
+
+// newlib also requires implementing locks for the application's environment memory space,
+// accessed by newlib's setenv() and getenv() functions.
+// As these are trivial functions, momentarily suspend task switching (rather than semaphore).
+// Not required (and trimmed by linker) in applications not using environment variables.
+// ToDo: Move __env_lock/unlock to a separate newlib helper file.
+void __env_lock(void)    {       vTaskSuspendAll(); }
+void __env_unlock(void)  { (void)xTaskResumeAll();  }
+
+#if defined(configHEAP_PRESSURE_LOW_WATERMARK_BYTES) // DRN heap pressure notification
+  // Heap is "under pressure" when free heap drops below configHEAP_PRESSURE_LOW_WATERMARK_BYTES,
+  // and remains so until free heap rises above configHEAP_PRESSURE_HIGH_WATERMARK_BYTES (hysteresis).
+  // Free heap is estimated cheaply from the wrappers' HeapBytesInUse, so the full set of malloc
+  // wrappers (see below) must be enabled with linker options.
+  // Listener tasks get a notification (bits set) on each state change, and an optional event group
+  // bit is set while under pressure, so producers (logging, network RX) can back off early.
+  #ifndef configHEAP_PRESSURE_HIGH_WATERMARK_BYTES
+    #define configHEAP_PRESSURE_HIGH_WATERMARK_BYTES (2*(configHEAP_PRESSURE_LOW_WATERMARK_BYTES))
+  #endif
+  #if configHEAP_PRESSURE_HIGH_WATERMARK_BYTES < configHEAP_PRESSURE_LOW_WATERMARK_BYTES
+    #error "configHEAP_PRESSURE_HIGH_WATERMARK_BYTES must not be less than configHEAP_PRESSURE_LOW_WATERMARK_BYTES"
+  #endif
+  #ifndef configHEAP_PRESSURE_MAX_LISTENERS
+    #define configHEAP_PRESSURE_MAX_LISTENERS 4
+  #endif
+  extern size_t HeapBytesInUse; // maintained by malloc wrappers below
+  static bool heapUnderPressure;
+  static bool heapPressureChanged; // state change not yet delivered to listeners
+  static struct { TaskHandle_t task; uint32_t notifyBits; } heapPressureListeners[configHEAP_PRESSURE_MAX_LISTENERS];
+  static EventGroupHandle_t heapPressureEventGroup;
+  static EventBits_t heapPressureEventBits;
+
+  //! Register a task to be notified (bits set via xTaskNotify) when heap pressure starts or ends.
+  BaseType_t xPortHeapPressureAddListener( TaskHandle_t xTask, uint32_t ulNotifyBits ) {
+    BaseType_t result = pdFAIL;
+    vTaskSuspendAll();
+    for(int i=0; i<configHEAP_PRESSURE_MAX_LISTENERS; i++) {
+      if(heapPressureListeners[i].task == NULL) {
+        heapPressureListeners[i].task = xTask;
+        heapPressureListeners[i].notifyBits = ulNotifyBits;
+        result = pdPASS;
+        break;
+      }
+    }
+    (void)xTaskResumeAll();
+    return result;
+  }
+  //! Remove a listener (ie before deleting the task).
+  void vPortHeapPressureRemoveListener( TaskHandle_t xTask ) {
+    vTaskSuspendAll();
+    for(int i=0; i<configHEAP_PRESSURE_MAX_LISTENERS; i++) {
+      if(heapPressureListeners[i].task == xTask) heapPressureListeners[i].task = NULL;
+    }
+    (void)xTaskResumeAll();
+  }
+  //! Event group bits set while heap is under pressure, cleared otherwise.
+  void vPortHeapPressureSetEventGroup( EventGroupHandle_t xEventGroup, EventBits_t uxBits ) {
+    heapPressureEventBits = uxBits;
+    heapPressureEventGroup = xEventGroup;
+    heapPressureChanged = true; // publish current state on next allocation
+  }
+  BaseType_t xPortIsHeapUnderPressure( void ) { return heapUnderPressure ? pdTRUE : pdFALSE; }
+
+  // Called with wrapper lock held.
+  static void heapPressureUpdate(void) {
+    size_t freeBytes = heapBytesAvailableFromSbrk() + (size_t)(currentHeapEnd-&__HeapBase) - HeapBytesInUse;
+    if(!heapUnderPressure && freeBytes < (size_t)(configHEAP_PRESSURE_LOW_WATERMARK_BYTES)) {
+      heapUnderPressure = heapPressureChanged = true;
+    } else if(heapUnderPressure && freeBytes > (size_t)(configHEAP_PRESSURE_HIGH_WATERMARK_BYTES)) {
+      heapUnderPressure = false;
+      heapPressureChanged = true;
+    }
+  }
+  // Called without wrapper lock, from task context only.
+  static void heapPressureNotify(void) {
+    bool pressure = heapUnderPressure;
+    for(int i=0; i<configHEAP_PRESSURE_MAX_LISTENERS; i++) {
+      TaskHandle_t t = heapPressureListeners[i].task;
+      if(t) (void)xTaskNotify(t, heapPressureListeners[i].notifyBits, eSetBits);
+    }
+    if(heapPressureEventGroup) {
+      if(pressure) (void)xEventGroupSetBits  (heapPressureEventGroup, heapPressureEventBits);
+      else         (void)xEventGroupClearBits(heapPressureEventGroup, heapPressureEventBits);
+    }
+  }
+#endif
+
+#if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING // DRN per-task heap accounting and quotas
+  // Every block allocated through the malloc wrappers is tagged with its owning task, and live bytes
+  // are kept per task, so a misbehaving task can be spotted (xPortGetTaskHeapUsage) and contained
+  // (vPortSetTaskHeapQuota): once over quota, that task's allocations fail instead of the system's.
+  // Tasks are assigned an accounting slot on first allocation; the slot number is kept in the task's
+  // thread-local storage pointer configHEAP_TASK_ACCOUNTING_TLS_INDEX.
+  // Slot 0 accounts allocations from ISRs, from before the scheduler starts, or when the table is full.
+  // Call vPortHeapTaskDeleted from traceTASK_DELETE so the slot is recycled; the deleted task's blocks
+  // are then no longer charged to anyone.
+  #ifndef configHEAP_TASK_ACCOUNTING_TLS_INDEX
+    #error "configHEAP_TASK_ACCOUNTING_TLS_INDEX must specify a thread-local storage pointer reserved for heap accounting"
+  #endif
+  #if configHEAP_TASK_ACCOUNTING_TLS_INDEX >= configNUM_THREAD_LOCAL_STORAGE_POINTERS
+    #error "configHEAP_TASK_ACCOUNTING_TLS_INDEX must be less than configNUM_THREAD_LOCAL_STORAGE_POINTERS"
+  #endif
+  #ifndef configHEAP_TASK_ACCOUNTING_MAX_TASKS
+    #define configHEAP_TASK_ACCOUNTING_MAX_TASKS 16 // including slot 0
+  #endif
+  static struct {
+    TaskHandle_t task;          // NULL: slot unused
+    uint16_t generation;        // incremented when slot is recycled
+    size_t liveBytes;           // newlib's usable size of blocks currently owned
+    size_t peakBytes;
+    size_t quota;               // 0: unlimited
+    uint32_t quotaFailures;
+  } heapTaskUsage[configHEAP_TASK_ACCOUNTING_MAX_TASKS];
+
+  // Called with wrapper lock held (or within critical section).
+  static int heapTaskSlot(TaskHandle_t task, bool claim) {
+    if(task == NULL) return 0;
+    int slot = (int)(intptr_t)pvTaskGetThreadLocalStoragePointer(task, configHEAP_TASK_ACCOUNTING_TLS_INDEX);
+    if(slot || !claim) return slot;
+    for(slot=1; slot<configHEAP_TASK_ACCOUNTING_MAX_TASKS; slot++) {
+      if(heapTaskUsage[slot].task == NULL) {
+        heapTaskUsage[slot].task = task;
+        vTaskSetThreadLocalStoragePointer(task, configHEAP_TASK_ACCOUNTING_TLS_INDEX, (void *)(intptr_t)slot);
+        return slot;
+      }
+    }
+    return 0; // table full: charge to system
+  }
+  static int heapCurrentTaskSlot(void) {
+    if(xTaskGetSchedulerState()==taskSCHEDULER_NOT_STARTED || xPortIsInsideInterrupt()) return 0;
+    return heapTaskSlot(xTaskGetCurrentTaskHandle(), true);
+  }
+
+  //! Limit heap owned by a task (NULL for current task); 0 removes the limit.
+  void vPortSetTaskHeapQuota( TaskHandle_t xTask, size_t xQuotaBytes ) {
+    vTaskSuspendAll();
+    int slot = heapTaskSlot(xTask ? xTask : xTaskGetCurrentTaskHandle(), true);
+    if(slot) heapTaskUsage[slot].quota = xQuotaBytes; // no quota for system slot
+    (void)xTaskResumeAll();
+  }
+  //! Heap currently owned by a task (NULL for system: ISRs, pre-scheduler, overflow), optionally its
+  //! peak usage and count of allocations failed for exceeding quota.
+  size_t xPortGetTaskHeapUsage( TaskHandle_t xTask, size_t *pxPeakBytes, uint32_t *pulQuotaFailures ) {
+    vTaskSuspendAll();
+    int slot = heapTaskSlot(xTask, false);
+    size_t live = heapTaskUsage[slot].liveBytes;
+    if(pxPeakBytes) *pxPeakBytes = heapTaskUsage[slot].peakBytes;
+    if(pulQuotaFailures) *pulQuotaFailures = heapTaskUsage[slot].quotaFailures;
+    (void)xTaskResumeAll();
+    return live;
+  }
+  // Recycle a deleted task's accounting slot.
+  static void heapTaskAccountingDeleted( TaskHandle_t xTask ) {
+    int slot = heapTaskSlot(xTask, false);
+    if(slot == 0) return;
+    heapTaskUsage[slot].task = NULL;
+    heapTaskUsage[slot].generation++; // outstanding blocks are now orphans
+    heapTaskUsage[slot].liveBytes = heapTaskUsage[slot].peakBytes = heapTaskUsage[slot].quota = 0;
+    heapTaskUsage[slot].quotaFailures = 0;
+  }
+#endif
+
+#if defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS // DRN leak detector (debug)
+  // Each outstanding block is recorded with its owning task and caller's PC in a fixed-size hash
+  // table (16 bytes per entry; blocks beyond capacity are counted in HeapLeakTableOverflows).
+  // When a task is deleted (vPortHeapTaskDeleted from traceTASK_DELETE) its outstanding blocks are
+  // marked as leaked, and optionally vApplicationHeapLeakHook is called with a summary.
+  // vPortHeapLeakDump lists outstanding blocks, one line each, for symbolizing PCs on the host.
+  #if (configHEAP_LEAK_DETECTOR_BLOCKS & (configHEAP_LEAK_DETECTOR_BLOCKS-1)) != 0
+    #error "configHEAP_LEAK_DETECTOR_BLOCKS must be a power of 2"
+  #endif
+  typedef struct {
+    void *block;         // application's pointer; NULL: entry unused
+    void *pc;            // allocation call site
+    TaskHandle_t owner;  // NULL: ISR, pre-scheduler, or deleted task
+    uint32_t size:31;    // usable size
+    uint32_t leaked:1;   // owner deleted while block outstanding
+  } heapLeakEntry_t;
+  static heapLeakEntry_t heapLeakTable[configHEAP_LEAK_DETECTOR_BLOCKS];
+  uint32_t HeapLeakTableOverflows;
+  #if defined(configHEAP_LEAK_DETECTOR_HOOK) && configHEAP_LEAK_DETECTOR_HOOK
+    extern void vApplicationHeapLeakHook( TaskHandle_t xTask, uint32_t ulBlocks, size_t xBytes );
+  #endif
+
+  static unsigned heapLeakHash(void *block) {
+    return (unsigned)(((uintptr_t)block >> 3) * 2654435761u) & (configHEAP_LEAK_DETECTOR_BLOCKS-1);
+  }
+  // Called with wrapper lock held. Unused entry for block, or NULL if the table is full.
+  static heapLeakEntry_t *heapLeakNewEntry(void *block) {
+    unsigned i = heapLeakHash(block);
+    for(int n=0; n<configHEAP_LEAK_DETECTOR_BLOCKS; n++, i=(i+1)&(configHEAP_LEAK_DETECTOR_BLOCKS-1)) {
+      if(heapLeakTable[i].block == NULL) return &heapLeakTable[i];
+    }
+    HeapLeakTableOverflows++;
+    return NULL;
+  }
+  // Called with wrapper lock held.
+  static void heapLeakInsert(void *block, size_t size, void *pc) {
+    heapLeakEntry_t *e = heapLeakNewEntry(block);
+    if(e == NULL) return;
+    e->block = block;
+    e->pc = pc;
+    e->owner = (xTaskGetSchedulerState()==taskSCHEDULER_NOT_STARTED || xPortIsInsideInterrupt()) ?
+               NULL : xTaskGetCurrentTaskHandle();
+    e->size = (uint32_t)size;
+    e->leaked = 0;
+  }
+  // Called with wrapper lock held. Copy block's entry to *pEntry; false if not recorded.
+  static bool heapLeakFind(void *block, heapLeakEntry_t *pEntry) {
+    unsigned i = heapLeakHash(block);
+    for(int n=0; n<configHEAP_LEAK_DETECTOR_BLOCKS; n++, i=(i+1)&(configHEAP_LEAK_DETECTOR_BLOCKS-1)) {
+      if(heapLeakTable[i].block == NULL) return false;
+      if(heapLeakTable[i].block == block) { *pEntry = heapLeakTable[i]; return true; }
+    }
+    return false;
+  }
+  // Called with wrapper lock held.
+  static void heapLeakRemove(void *block) {
+    unsigned i = heapLeakHash(block);
+    for(int n=0; heapLeakTable[i].block != block; n++, i=(i+1)&(configHEAP_LEAK_DETECTOR_BLOCKS-1)) {
+      if(heapLeakTable[i].block == NULL || n == configHEAP_LEAK_DETECTOR_BLOCKS) return; // not recorded (overflow)
+    }
+    // Backward-shift deletion keeps linear-probe chains intact without tombstones
+    for(unsigned j=i;;) {
+      j = (j+1)&(configHEAP_LEAK_DETECTOR_BLOCKS-1);
+      if(heapLeakTable[j].block == NULL) break;
+      unsigned k = heapLeakHash(heapLeakTable[j].block); // entry j's home; stays put if home is in (i,j]
+      if((i<=j) ? ((i<k) && (k<=j)) : ((i<k) || (k<=j))) continue;
+      heapLeakTable[i] = heapLeakTable[j];
+      i = j;
+    }
+    heapLeakTable[i].block = NULL;
+  }
+  // Mark deleted task's outstanding blocks as leaked.
+  static void heapLeakTaskDeleted( TaskHandle_t xTask ) {
+    uint32_t blocks = 0;
+    size_t bytes = 0;
+    for(int i=0; i<configHEAP_LEAK_DETECTOR_BLOCKS; i++) {
+      if(heapLeakTable[i].block && heapLeakTable[i].owner == xTask) {
+        heapLeakTable[i].owner = NULL;
+        heapLeakTable[i].leaked = 1;
+        blocks++;
+        bytes += heapLeakTable[i].size;
+      }
+    }
+    #if defined(configHEAP_LEAK_DETECTOR_HOOK) && configHEAP_LEAK_DETECTOR_HOOK
+      if(blocks) vApplicationHeapLeakHook(xTask, blocks, bytes);
+    #else
+      (void)bytes;
+    #endif
+  }
+
+  //! Output one line per outstanding block owned by xTask, or if xTask is NULL, blocks leaked by deleted
+  //! tasks and blocks allocated from ISRs or before the scheduler started:
+  //!   heapleak <block> <size> <pc> <task name | (deleted) | (system)>
+  //! Runs with the scheduler suspended only while copying each entry, so blocks allocated or
+  //! freed during the dump may be missed or listed twice.
+  void vPortHeapLeakDump( TaskHandle_t xTask, void (*pfnOutput)( const char *pcLine ) ) {
+    for(int i=0; i<configHEAP_LEAK_DETECTOR_BLOCKS; i++) {
+      UBaseType_t usis = heapWrapLock();
+      heapLeakEntry_t e = heapLeakTable[i];
+      const char *name = (e.owner == NULL) ? (e.leaked ? "(deleted)" : "(system)") : pcTaskGetName(e.owner);
+      heapWrapUnlock(usis);
+      if(e.block == NULL || e.owner != xTask) continue;
+      char line[48+configMAX_TASK_NAME_LEN];
+      snprintf(line, sizeof(line), "heapleak %p %lu %p %s\n", e.block, (unsigned long)e.size, e.pc, name);
+      pfnOutput(line);
+    }
+  }
+#endif
+
+#if (defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING) || \
+    (defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS)
+  //! Forget deleted task. Call from traceTASK_DELETE (runs in a critical section; task still valid).
+  void vPortHeapTaskDeleted( void *xTask ) {
+    #if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING
+      heapTaskAccountingDeleted((TaskHandle_t)xTask);
+    #endif
+    #if defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS
+      heapLeakTaskDeleted((TaskHandle_t)xTask);
+    #endif
+  }
+#endif
+
+#if (defined(configHEAP_FRAG_ANALYZER_CHUNKS_PER_SLICE) && configHEAP_FRAG_ANALYZER_CHUNKS_PER_SLICE) || \
+    (defined(configHEAP_CHECK_CHUNKS_PER_SLICE) && configHEAP_CHECK_CHUNKS_PER_SLICE)
+  #define HEAP_WALKER 1
+#endif
+#if defined(HEAP_WALKER) // DRN walk newlib's heap chunk by chunk
+  // Walks newlib's chunks from the start of the heap up to currentHeapEnd. This depends upon newlib's
+  // internal malloc layout (same for newlib 2.5 through 4.2):
+  // - full newlib (dlmalloc): each chunk starts with prev_size and size words; a chunk is in use if
+  //   PREV_INUSE is set in the following chunk's size. The top chunk (bin 0) extends to the end of heap.
+  // - newlib-nano (_NANO_MALLOC): each chunk starts with its size; free chunks are on an
+  //   address-ordered free list.
+  // A walk may span several lock periods, so it restarts if newlib took its lock in between.
+  #if defined(_NANO_MALLOC)
+    typedef struct heapNanoChunk { long size; struct heapNanoChunk *next; } heapNanoChunk_t; // newlib-nano's chunk
+    extern heapNanoChunk_t *__malloc_free_list;
+    extern char *__malloc_sbrk_start;  // NULL until first sbrk
+    #define HEAP_CHUNK_ALIGN sizeof(void *)
+    #define HEAP_CHUNK_MIN sizeof(heapNanoChunk_t)
+  #else
+    extern char *__malloc_sbrk_base;   // (char *)-1 until first sbrk
+    extern void *__malloc_av_[];       // bins; __malloc_av_[2] is the top chunk
+    #define HEAP_CHUNK_ALIGN 8
+    #define HEAP_CHUNK_MIN (4*sizeof(size_t))
+  #endif
+  typedef struct {
+    char *next;                // next chunk to examine
+    uint32_t mallocLockCount;  // heapMallocLockCount when walk started
+    #if defined(_NANO_MALLOC)
+      heapNanoChunk_t *freeCursor; // next free-list entry; should be at or above 'next'
+    #endif
+  } heapWalker_t;
+  typedef enum { HEAP_WALK_CHUNK, HEAP_WALK_END, HEAP_WALK_BAD_CHUNK } heapWalkResult_t;
+
+  // Called with wrapper lock held.
+  static void heapWalkStart(heapWalker_t *w) {
+    w->mallocLockCount = heapMallocLockCount;
+    #if defined(_NANO_MALLOC)
+      w->freeCursor = __malloc_free_list;
+      w->next = (__malloc_sbrk_start == NULL) ? currentHeapEnd :
+                (char *)(((uintptr_t)__malloc_sbrk_start + HEAP_CHUNK_ALIGN-1) & ~(uintptr_t)(HEAP_CHUNK_ALIGN-1));
+    #else
+      // dlmalloc aligns the first chunk's user area (after prev_size and size words)
+      w->next = (__malloc_sbrk_base == (char *)-1) ? currentHeapEnd :
+                (char *)(((uintptr_t)__malloc_sbrk_base + 2*sizeof(size_t) + HEAP_CHUNK_ALIGN-1) & ~(uintptr_t)(HEAP_CHUNK_ALIGN-1))
+                - 2*sizeof(size_t);
+    #endif
+  }
+  // Called with wrapper lock held. Has newlib possibly changed the heap since walk started?
+  static bool heapWalkStale(const heapWalker_t *w) { return w->mallocLockCount != heapMallocLockCount; }
+  // Called with wrapper lock held. Examine next chunk. If it is unrecognizable, *pChunk is the bad address.
+  static heapWalkResult_t heapWalkStep(heapWalker_t *w, char **pChunk, size_t *pSize, bool *pInUse) {
+    char *p = w->next;
+    *pChunk = p;
+    if(p >= currentHeapEnd) return HEAP_WALK_END;
+    #if defined(_NANO_MALLOC)
+      size_t size = (size_t)((heapNanoChunk_t *)p)->size;
+      if(size < HEAP_CHUNK_MIN || (size & (HEAP_CHUNK_ALIGN-1)) || size > (size_t)(currentHeapEnd-p)) return HEAP_WALK_BAD_CHUNK;
+      if(w->freeCursor && (char *)w->freeCursor < p) {
+        *pChunk = (char *)w->freeCursor; // free-list entry isn't a chunk
+        return HEAP_WALK_BAD_CHUNK;
+      }
+      bool inUse = ((char *)w->freeCursor != p);
+      if(!inUse) w->freeCursor = w->freeCursor->next;
+    #else
+      size_t size = ((size_t *)p)[1] & ~(size_t)3; // less PREV_INUSE and IS_MMAPPED bits
+      if(size < HEAP_CHUNK_MIN || (size & (HEAP_CHUNK_ALIGN-1)) || size > (size_t)(currentHeapEnd-p)) return HEAP_WALK_BAD_CHUNK;
+      bool inUse;
+      if(p == (char *)__malloc_av_[2]) {
+        inUse = false; // top chunk
+      } else if(size + 2*sizeof(size_t) > (size_t)(currentHeapEnd-p)) {
+        return HEAP_WALK_BAD_CHUNK; // only the top chunk may end at end of heap
+      } else {
+        inUse = ((size_t *)(p+size))[1] & 1; // next chunk's PREV_INUSE
+      }
+    #endif
+    w->next = p + size;
+    *pSize = size;
+    *pInUse = inUse;
+    return HEAP_WALK_CHUNK;
+  }
+#endif
+
+#if defined(configHEAP_FRAG_ANALYZER_CHUNKS_PER_SLICE) && configHEAP_FRAG_ANALYZER_CHUNKS_PER_SLICE // DRN fragmentation analyzer
+  // Tells exhaustion from fragmentation: call vPortHeapFragAnalyzeFromIdleHook from vApplicationIdleHook,
+  // and each call examines at most configHEAP_FRAG_ANALYZER_CHUNKS_PER_SLICE chunks with the scheduler
+  // suspended. When a walk over the whole heap completes, its results are published for
+  // xPortGetHeapFragStats. If configHEAP_FRAG_ANALYZER_MAP_RUNS is set, the walk also records the heap's
+  // layout (alternating runs of used and free memory, 4 bytes each) for vPortHeapMapDump.
+  #ifndef configHEAP_FRAG_ANALYZER_MAP_RUNS
+    #define configHEAP_FRAG_ANALYZER_MAP_RUNS 0
+  #endif
+  static heapWalker_t heapFragWalker;
+  static bool heapFragWalking;
+  static HeapFragStats_t heapFragPartial, heapFragStats;
+  static size_t heapFragLastFree;      // size of last chunk examined if free (extends into unsbrk'd heap)
+  #if configHEAP_FRAG_ANALYZER_MAP_RUNS
+    typedef struct { uint32_t size:31, free:1; } heapMapRun_t;
+    static heapMapRun_t heapMapRuns[2][configHEAP_FRAG_ANALYZER_MAP_RUNS];
+    static struct { char *start; size_t runs; bool truncated; } heapMap[2];
+    static int heapMapPublished;       // index of published map; other is being recorded
+    static bool heapMapDumping;        // don't publish a new map while dumping
+  #endif
+
+  // Called with wrapper lock held.
+  static void heapFragChunk(char *chunk, size_t size, bool inUse) {
+    HeapFragStats_t *s = &heapFragPartial;
+    if(inUse) {
+      s->ulUsedChunks++;
+      s->xUsedBytes += size;
+      heapFragLastFree = 0;
+    } else {
+      s->ulFreeChunks++;
+      s->xFreeBytes += size;
+      if(size > s->xLargestFreeBlock) s->xLargestFreeBlock = size;
+      int bucket = 0;
+      for(size_t n = size>>5; n && bucket < HEAP_FRAG_HISTOGRAM_BUCKETS-1; n >>= 1) bucket++;
+      if(s->ausFreeChunkHistogram[bucket] < UINT16_MAX) s->ausFreeChunkHistogram[bucket]++;
+      heapFragLastFree = size;
+    }
+    #if configHEAP_FRAG_ANALYZER_MAP_RUNS
+      int m = 1-heapMapPublished;
+      if(heapMap[m].start == NULL) heapMap[m].start = chunk;
+      heapMapRun_t *r = &heapMapRuns[m][heapMap[m].runs ? heapMap[m].runs-1 : 0];
+      if(heapMap[m].runs && r->free == !inUse) {
+        r->size += size; // extend current run
+      } else if(heapMap[m].runs < configHEAP_FRAG_ANALYZER_MAP_RUNS) {
+        r = &heapMapRuns[m][heapMap[m].runs++];
+        r->size = size;
+        r->free = !inUse;
+      } else {
+        heapMap[m].truncated = true;
+      }
+    #else
+      (void)chunk;
+    #endif
+  }
+  // Called with wrapper lock held.
+  static void heapFragPublish(void) {
+    HeapFragStats_t *s = &heapFragPartial;
+    size_t notYetSbrkd = heapBytesAvailableFromSbrk();
+    s->xFreeBytes += notYetSbrkd;
+    if(heapFragLastFree + notYetSbrkd > s->xLargestFreeBlock) s->xLargestFreeBlock = heapFragLastFree + notYetSbrkd;
+    s->usFragmentationPermille = s->xFreeBytes ?
+      (uint16_t)(1000 - (uint32_t)(((uint64_t)s->xLargestFreeBlock*1000) / s->xFreeBytes)) : 0;
+    s->ulWalksCompleted = heapFragStats.ulWalksCompleted + 1;
+    s->ulWalksRestarted = heapFragStats.ulWalksRestarted;
+    heapFragStats = *s;
+    #if configHEAP_FRAG_ANALYZER_MAP_RUNS
+      if(!heapMapDumping) heapMapPublished = 1-heapMapPublished;
+    #endif
+  }
+
+  //! Call from vApplicationIdleHook: advances the fragmentation analysis by one bounded slice.
+  void vPortHeapFragAnalyzeFromIdleHook( void ) {
+    UBaseType_t usis = heapWrapLock();
+    if(heapFragWalking && heapWalkStale(&heapFragWalker)) {
+      heapFragStats.ulWalksRestarted++; // heap changed under us; start over
+      heapFragWalking = false;
+    }
+    if(!heapFragWalking) {
+      heapWalkStart(&heapFragWalker);
+      memset(&heapFragPartial, 0, sizeof(heapFragPartial));
+      heapFragLastFree = 0;
+      #if configHEAP_FRAG_ANALYZER_MAP_RUNS
+        heapMap[1-heapMapPublished].start = NULL;
+        heapMap[1-heapMapPublished].runs = 0;
+        heapMap[1-heapMapPublished].truncated = false;
+      #endif
+      heapFragWalking = true;
+    }
+    for(int n=0; n<configHEAP_FRAG_ANALYZER_CHUNKS_PER_SLICE; n++) {
+      char *chunk;
+      size_t size;
+      bool inUse;
+      heapWalkResult_t result = heapWalkStep(&heapFragWalker, &chunk, &size, &inUse);
+      if(result == HEAP_WALK_CHUNK) {
+        heapFragChunk(chunk, size, inUse);
+        continue;
+      }
+      if(result == HEAP_WALK_END) heapFragPublish(); // else unrecognizable chunk: abandon this walk
+      heapFragWalking = false;
+      break;
+    }
+    heapWrapUnlock(usis);
+  }
+  //! Results of the most recently completed walk; pdFALSE if no walk has completed yet.
+  BaseType_t xPortGetHeapFragStats( HeapFragStats_t *pxStats ) {
+    UBaseType_t usis = heapWrapLock();
+    *pxStats = heapFragStats;
+    heapWrapUnlock(usis);
+    return pxStats->ulWalksCompleted ? pdTRUE : pdFALSE;
+  }
+  #if configHEAP_FRAG_ANALYZER_MAP_RUNS
+    //! Output the heap layout recorded by the most recently completed walk, one line per run:
+    //!   heapmap <address> <bytes> <# used | . free | - not yet provided to newlib>
+    //! followed by "heapmap truncated" if configHEAP_FRAG_ANALYZER_MAP_RUNS was too small.
+    void vPortHeapMapDump( void (*pfnOutput)( const char *pcLine ) ) {
+      UBaseType_t usis = heapWrapLock();
+      heapMapDumping = true;
+      int m = heapMapPublished;
+      size_t notYetSbrkd = heapBytesAvailableFromSbrk();
+      heapWrapUnlock(usis);
+      char line[48];
+      char *p = heapMap[m].start;
+      for(size_t i=0; i<heapMap[m].runs; i++) {
+        snprintf(line, sizeof(line), "heapmap %p %lu %c\n", p, (unsigned long)heapMapRuns[m][i].size, heapMapRuns[m][i].free ? '.' : '#');
+        pfnOutput(line);
+        p += heapMapRuns[m][i].size;
+      }
+      if(heapMap[m].truncated) {
+        pfnOutput("heapmap truncated\n");
+      } else {
+        snprintf(line, sizeof(line), "heapmap %p %lu -\n", p, (unsigned long)notYetSbrkd);
+        pfnOutput(line);
+      }
+      heapMapDumping = false;
+    }
+  #endif
+#endif
+
+#if defined(configHEAP_CHECK_CHUNKS_PER_SLICE) && configHEAP_CHECK_CHUNKS_PER_SLICE // DRN heap integrity checker
+  // Catches heap corruption (stray DMA, buffer overrun) soon after it happens, rather than as a crash
+  // deep inside malloc hours later. Call vPortHeapCheckFromIdleHook from vApplicationIdleHook; each call
+  // validates at most configHEAP_CHECK_CHUNKS_PER_SLICE chunks (size fields, in-use flags, free-list
+  // links) with the scheduler suspended, resuming where the previous call stopped. A pass restarts if
+  // the heap changed in between. On damage, vApplicationHeapCorruptHook is called (once) with the
+  // corrupt address, and checking stops.
+  extern void vApplicationHeapCorruptHook( void *pvAddress );
+  static heapWalker_t heapCheckWalker;
+  static bool heapCheckWalking;
+  static bool heapCheckPrevInUse;  // previous chunk in use (or walk just started)
+  static bool heapCheckFailed;
+  uint32_t HeapCheckPasses;        // complete passes over the heap without finding damage
+  uint32_t HeapCheckRestarts;      // passes abandoned because heap changed
+
+  #if !defined(_NANO_MALLOC)
+    #define HEAP_DL_NAV 128 // number of dlmalloc bins
+    // May this be a free-list link: a chunk in the heap, or one of newlib's bin headers?
+    static bool heapCheckLink(char *link) {
+      if((uintptr_t)link & (sizeof(size_t)-1)) return false;
+      if((link >= &__HeapBase) && (link < currentHeapEnd)) return true;
+      return (link >= (char *)__malloc_av_) && (link <= (char *)&__malloc_av_[2*(HEAP_DL_NAV-1)]);
+    }
+  #endif
+  // Called with wrapper lock held. Returns corrupt address, or NULL if chunk is OK.
+  static void *heapCheckChunk(char *chunk, size_t size, bool inUse) {
+    if(!inUse && !heapCheckPrevInUse) return chunk; // newlib always merges adjacent free chunks
+    #if defined(_NANO_MALLOC)
+      if(!inUse) {
+        char *next = (char *)((heapNanoChunk_t *)chunk)->next;
+        if(next && ((next <= chunk+size) || (next >= currentHeapEnd))) return &((heapNanoChunk_t *)chunk)->next;
+      }
+    #else
+      size_t *h = (size_t *)chunk; // prev_size, size, and if free: fd, bk
+      if(h[1] & 2) return &h[1]; // IS_MMAPPED: newlib never mmaps
+      if(((h[1] & 1) != 0) != heapCheckPrevInUse) return &h[1];
+      if(!inUse && (chunk == (char *)__malloc_av_[2])) {
+        if(chunk+size != currentHeapEnd) return &h[1]; // top chunk must extend to end of heap
+      } else if(!inUse) {
+        char *fd = (char *)h[2], *bk = (char *)h[3];
+        if(((size_t *)(chunk+size))[0] != size) return chunk+size; // next chunk's prev_size
+        if(!heapCheckLink(fd) || (((char **)fd)[3] != chunk)) return &h[2];
+        if(!heapCheckLink(bk) || (((char **)bk)[2] != chunk)) return &h[3];
+      }
+    #endif
+    heapCheckPrevInUse = inUse;
+    return NULL;
+  }
+
+  //! Call from vApplicationIdleHook: validates the next few chunks of newlib's heap.
+  void vPortHeapCheckFromIdleHook( void ) {
+    void *corrupt = NULL;
+    if(heapCheckFailed) return;
+    UBaseType_t usis = heapWrapLock();
+    if(heapCheckWalking && heapWalkStale(&heapCheckWalker)) {
+      HeapCheckRestarts++;
+      heapCheckWalking = false;
+    }
+    if(!heapCheckWalking) {
+      heapWalkStart(&heapCheckWalker);
+      heapCheckPrevInUse = true;
+      heapCheckWalking = true;
+    }
+    for(int n=0; n<configHEAP_CHECK_CHUNKS_PER_SLICE && !corrupt; n++) {
+      char *chunk;
+      size_t size;
+      bool inUse;
+      heapWalkResult_t result = heapWalkStep(&heapCheckWalker, &chunk, &size, &inUse);
+      if(result == HEAP_WALK_CHUNK) {
+        corrupt = heapCheckChunk(chunk, size, inUse);
+      } else if(result == HEAP_WALK_BAD_CHUNK) {
+        corrupt = chunk;
+      } else {
+        #if defined(_NANO_MALLOC)
+          if(heapCheckWalker.freeCursor) corrupt = heapCheckWalker.freeCursor; // free-list entry beyond heap
+        #endif
+        if(!corrupt) HeapCheckPasses++;
+        heapCheckWalking = false;
+        break;
+      }
+    }
+    if(corrupt) heapCheckFailed = true;
+    heapWrapUnlock(usis);
+    if(corrupt) vApplicationHeapCorruptHook(corrupt);
+  }
+#endif
+
+#if 1 // Provide malloc debug and accounting wrappers
+  /// /brief  Wrap malloc/malloc_r to help debug who requests memory and why.
+  /// To use these, add linker options: -Xlinker --wrap=malloc -Xlinker --wrap=_malloc_r
+  /// For HeapBytesInUse accounting (and features that depend on it), wrap all of newlib's allocation
+  /// and release entry points: -Xlinker --wrap=_malloc_r -Xlinker --wrap=_free_r
+  ///                           -Xlinker --wrap=_realloc_r -Xlinker --wrap=_memalign_r
+  ///                           -Xlinker --wrap=_calloc_r -Xlinker --wrap=_malloc_usable_size_r
+  /// (newlib's valloc, strdup, etc. use these internally).
+  /// _calloc_r and _malloc_usable_size_r wrappers are required when blocks carry a header (ie configHEAP_TASK_ACCOUNTING
+  /// or configHEAP_REDZONE).
+  // Note: These functions are normally unused and stripped by linker.
+  size_t TotalMallocdBytes;
+  int MallocCallCnt;
+  // Counters updated without the wrapper lock use atomic read-modify-write (LDREX/STREX on Cortex-M3/4/7).
+  #define HEAP_ATOMIC_ADD(counter, n) (void)__atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+  static bool inside_malloc;
+  size_t HeapBytesInUse; // sum of malloc_usable_size for all outstanding blocks
+  #if defined(configHEAP_REDZONE) && configHEAP_REDZONE // DRN redzone debug mode
+    // Each block is bracketed by canaries (HEAP_REDZONE_SIZE bytes of HEAP_REDZONE_FILL), and its
+    // requested size and owner are recorded in its header. Canaries are verified when the block is freed or
+    // reallocated (realloc always moves the block, so stale pointers hit the quarantine). Freed blocks are
+    // poisoned and held in a FIFO quarantine of configHEAP_REDZONE_QUARANTINE_BLOCKS blocks; a block leaving
+    // quarantine is checked for writes after free. Damage is reported to vApplicationHeapCorruptHook (after
+    // the wrapper lock is released), and the damaged block is never returned to newlib.
+    #define HEAP_REDZONE_SIZE 8
+    #define HEAP_REDZONE_FILL 0xFD
+    #define HEAP_POISON_FILL  0xDD
+    #ifndef configHEAP_REDZONE_QUARANTINE_BLOCKS
+      #define configHEAP_REDZONE_QUARANTINE_BLOCKS 16
+    #endif
+    extern void vApplicationHeapCorruptHook( void *pvAddress );
+    static void *heapCorruptAddress; // damage found but not yet reported
+  #else
+    #define HEAP_REDZONE_SIZE 0
+  #endif
+  // newlib's realloc, memalign, and calloc may call malloc and free internally; only the outermost
+  // wrapper does the accounting (and adds any block header). Depth is protected by the wrapper lock.
+  static int heapWrapDepth;
+  static UBaseType_t heapWrapEnter(void) {
+    UBaseType_t usis = heapWrapLock();
+    heapWrapDepth++;
+    return usis;
+  }
+  static void heapWrapExit(UBaseType_t usis) {
+    #if defined(configHEAP_PRESSURE_LOW_WATERMARK_BYTES) // DRN heap pressure notification
+      bool deliver = false;
+      if(heapWrapDepth == 1) {
+        heapPressureUpdate();
+        deliver = heapPressureChanged && !xPortIsInsideInterrupt() &&
+                  (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED);
+        if(deliver) heapPressureChanged = false;
+      }
+    #endif
+    #if defined(configHEAP_REDZONE) && configHEAP_REDZONE // DRN redzone debug mode
+      void *corrupt = NULL;
+      if(heapWrapDepth == 1) {
+        corrupt = heapCorruptAddress;
+        heapCorruptAddress = NULL;
+      }
+    #endif
+    heapWrapDepth--;
+    heapWrapUnlock(usis);
+    #if defined(configHEAP_PRESSURE_LOW_WATERMARK_BYTES) // DRN heap pressure notification
+      if(deliver) heapPressureNotify();
+    #endif
+    #if defined(configHEAP_REDZONE) && configHEAP_REDZONE // DRN redzone debug mode
+      if(corrupt) vApplicationHeapCorruptHook(corrupt);
+    #endif
+  }
+
+  #if (defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS) || \
+      (defined(configHEAP_ALLOC_STATS) && configHEAP_ALLOC_STATS) || (defined(configHEAP_LATENCY_STATS) && configHEAP_LATENCY_STATS) || \
+      (defined(configHEAP_BOOT_RECORD) && configHEAP_BOOT_RECORD)
+    #define HEAP_TRACK_CALLER 1
+  #endif
+  #if defined(HEAP_TRACK_CALLER)
+    // Outermost wrapper records the application's call site in heapBlockPC. Public entry points like
+    // pvPortMalloc note their caller in heapCallerPC first (holding the wrapper lock throughout), so the
+    // call site isn't newlib's malloc or the FreeRTOS wrapper.
+    static void *heapCallerPC, *heapBlockPC;
+    #define HEAP_NOTE_CALLER_BEGIN() UBaseType_t callerUsis = heapWrapLock(); \
+                                     if(heapCallerPC == NULL) heapCallerPC = __builtin_return_address(0)
+    #define HEAP_NOTE_CALLER_END()   heapCallerPC = NULL; heapWrapUnlock(callerUsis)
+    #define HEAP_NOTE_BLOCK_PC()     heapBlockPC = heapCallerPC ? heapCallerPC : __builtin_return_address(0)
+    #define HEAP_CALLER_PC()         (heapCallerPC ? heapCallerPC : __builtin_return_address(0))
+  #else
+    #define HEAP_NOTE_CALLER_BEGIN()
+    #define HEAP_NOTE_CALLER_END()
+    #define HEAP_NOTE_BLOCK_PC()
+  #endif
+
+  #if defined(configHEAP_ALLOC_STATS) && configHEAP_ALLOC_STATS // DRN allocation statistics
+    // Counts allocation requests by log2 size and by call site, and realloc growth, to guide optimization.
+    // Counters are updated atomically, so they can be exported or reset without suspending the scheduler.
+    // Call sites beyond configHEAP_ALLOC_STATS_CALL_SITES (power of 2) are counted in the overflow entry.
+    #ifndef configHEAP_ALLOC_STATS_CALL_SITES
+      #define configHEAP_ALLOC_STATS_CALL_SITES 64
+    #endif
+    #if (configHEAP_ALLOC_STATS_CALL_SITES & (configHEAP_ALLOC_STATS_CALL_SITES-1)) != 0
+      #error "configHEAP_ALLOC_STATS_CALL_SITES must be a power of 2"
+    #endif
+    #define HEAP_STATS_SIZE_BUCKETS 32 // [n] counts allocations of 2^n to 2^(n+1)-1 bytes ([0] also 0 bytes)
+    static struct {
+      uint32_t sizeHistogram[HEAP_STATS_SIZE_BUCKETS];
+      uint32_t reallocGrow, reallocShrink, reallocMoved;
+      uint32_t reallocGrowBytes;
+      struct { void *pc; uint32_t calls; uint32_t bytes; } sites[configHEAP_ALLOC_STATS_CALL_SITES+1]; // last: overflow
+    } heapStats;
+
+    static void heapStatsAllocation(size_t nbytes) {
+      int bucket = 0;
+      for(size_t n = nbytes>>1; n && bucket < HEAP_STATS_SIZE_BUCKETS-1; n >>= 1) bucket++;
+      HEAP_ATOMIC_ADD(heapStats.sizeHistogram[bucket], 1);
+      // Find or atomically claim this call site's entry (entries are only cleared by reset)
+      void *pc = heapBlockPC;
+      unsigned i = (unsigned)(((uintptr_t)pc >> 1) * 2654435761u) & (configHEAP_ALLOC_STATS_CALL_SITES-1);
+      int n;
+      for(n=0; n<configHEAP_ALLOC_STATS_CALL_SITES; n++, i=(i+1)&(configHEAP_ALLOC_STATS_CALL_SITES-1)) {
+        if(heapStats.sites[i].pc == pc) break;
+        void *expected = NULL;
+        if(__atomic_compare_exchange_n(&heapStats.sites[i].pc, &expected, pc, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) ||
+           expected == pc) break;
+      }
+      if(n == configHEAP_ALLOC_STATS_CALL_SITES) i = configHEAP_ALLOC_STATS_CALL_SITES; // table full
+      HEAP_ATOMIC_ADD(heapStats.sites[i].calls, 1);
+      HEAP_ATOMIC_ADD(heapStats.sites[i].bytes, (uint32_t)nbytes);
+    }
+    static void heapStatsRealloc(size_t oldSize, size_t nbytes, bool moved) {
+      if(nbytes > oldSize) {
+        HEAP_ATOMIC_ADD(heapStats.reallocGrow, 1);
+        HEAP_ATOMIC_ADD(heapStats.reallocGrowBytes, (uint32_t)(nbytes-oldSize));
+      } else {
+        HEAP_ATOMIC_ADD(heapStats.reallocShrink, 1);
+      }
+      if(moved) HEAP_ATOMIC_ADD(heapStats.reallocMoved, 1);
+    }
+    #define HEAP_STATS_ALLOCATION(nbytes) heapStatsAllocation(nbytes)
+
+    //! Zero all allocation statistics.
+    void vPortHeapAllocStatsReset( void ) {
+      UBaseType_t usis = heapWrapLock(); // no allocation may claim a call site while entries are cleared
+      memset(&heapStats, 0, sizeof(heapStats));
+      heapWrapUnlock(usis);
+    }
+    static uint8_t *heapStatsPut(uint8_t *p, uint8_t *end, uint32_t v) { // unsigned LEB128
+      do {
+        if(p == NULL || p >= end) return NULL;
+        *p++ = (uint8_t)((v & 0x7F) | ((v > 0x7F) ? 0x80 : 0));
+        v >>= 7;
+      } while(v);
+      return p;
+    }
+    //! Export allocation statistics in a compact binary format; returns bytes written (0 if buffer too small).
+    //! All values are unsigned LEB128 (7 bits per byte, least significant first, top bit set if more follow):
+    //!   format version (1), size buckets, [size histogram...],
+    //!   realloc grow count, shrink count, moved count, bytes grown,
+    //!   call sites, [pc, calls, bytes]... (pc 0: sites that didn't fit in the table)
+    size_t xPortHeapAllocStatsExport( uint8_t *pucBuffer, size_t xBufferSize ) {
+      uint8_t *p = pucBuffer, *end = pucBuffer + xBufferSize;
+      uint32_t sites = 0;
+      for(int i=0; i<=configHEAP_ALLOC_STATS_CALL_SITES; i++) sites += (heapStats.sites[i].calls != 0);
+      p = heapStatsPut(p, end, 1);
+      p = heapStatsPut(p, end, HEAP_STATS_SIZE_BUCKETS);
+      for(int i=0; i<HEAP_STATS_SIZE_BUCKETS; i++) p = heapStatsPut(p, end, heapStats.sizeHistogram[i]);
+      p = heapStatsPut(p, end, heapStats.reallocGrow);
+      p = heapStatsPut(p, end, heapStats.reallocShrink);
+      p = heapStatsPut(p, end, heapStats.reallocMoved);
+      p = heapStatsPut(p, end, heapStats.reallocGrowBytes);
+      p = heapStatsPut(p, end, sites);
+      for(int i=0; i<=configHEAP_ALLOC_STATS_CALL_SITES && sites; i++) {
+        if(heapStats.sites[i].calls == 0) continue;
+        p = heapStatsPut(p, end, (i < configHEAP_ALLOC_STATS_CALL_SITES) ? (uint32_t)(uintptr_t)heapStats.sites[i].pc : 0);
+        p = heapStatsPut(p, end, heapStats.sites[i].calls);
+        p = heapStatsPut(p, end, heapStats.sites[i].bytes);
+        sites--; // a site may have been added since counting
+      }
+      return p ? (size_t)(p - pucBuffer) : 0;
+    }
+  #else
+    #define HEAP_STATS_ALLOCATION(nbytes) ((void)0)
+  #endif
+
+  #if defined(configHEAP_LATENCY_STATS) && configHEAP_LATENCY_STATS // DRN heap operation latency
+    // Each operation's duration in cycles (configHEAP_LATENCY_CYCLES, by default the DWT cycle counter)
+    // goes into a log2 histogram, along with the maximum and its caller. Time spent taking and releasing
+    // heap locks (scheduler suspend/resume, including any task switch when the scheduler resumes) is
+    // totalled separately from time doing allocator work. Only the outermost operation is measured:
+    // pvPortMalloc's time includes the malloc it calls, which isn't recorded again under malloc.
+    // Public entry points hold the wrapper lock while heapLatencyNested is set, so it is only
+    // ever seen set by the operations they call.
+    #ifndef configHEAP_LATENCY_CYCLES_INIT
+      #define configHEAP_LATENCY_CYCLES_INIT() do { *(volatile uint32_t *)0xE000EDFCUL |= (1UL<<24); /* DEMCR TRCENA */ \
+                                                    *(volatile uint32_t *)0xE0001000UL |= 1UL; /* DWT_CTRL CYCCNTENA */ } while(0)
+    #endif
+    static HeapLatencyStats_t heapLatency[eHeapOpCount];
+
+    static void heapLatencyRecord(eHeapLatencyOp op, uint32_t start, uint32_t lockCyclesAtStart, void *pc) {
+      uint32_t cycles = configHEAP_LATENCY_CYCLES() - start;
+      uint32_t lockCycles = heapLockCycles - lockCyclesAtStart;
+      UBaseType_t usis = heapWrapLock();
+      HeapLatencyStats_t *s = &heapLatency[op];
+      int bucket = 0;
+      for(uint32_t n = cycles>>1; n && bucket < HEAP_LATENCY_BUCKETS-1; n >>= 1) bucket++;
+      s->aulHistogram[bucket]++;
+      s->ulCount++;
+      s->ullTotalCycles += cycles;
+      s->ullLockCycles += (lockCycles < cycles) ? lockCycles : cycles;
+      if(cycles > s->ulMaxCycles) {
+        s->ulMaxCycles = cycles;
+        s->pvMaxCaller = pc;
+      }
+      heapWrapUnlock(usis);
+    }
+    static int heapLatencyNested; // public entry point (pvPortMalloc, vPortFree) in progress
+    #define HEAP_LATENCY_BEGIN()  bool latencyOutermost = (heapWrapDepth == 0 && heapLatencyNested == 0); \
+                                  void *latencyPC = HEAP_CALLER_PC(); \
+                                  uint32_t latencyLockStart = heapLockCycles, latencyStart = configHEAP_LATENCY_CYCLES()
+    #define HEAP_LATENCY_END(op)  if(latencyOutermost) heapLatencyRecord(op, latencyStart, latencyLockStart, latencyPC)
+    // Public entry points: the malloc or free they call isn't recorded separately.
+    #define HEAP_LATENCY_ENTRY_BEGIN() HEAP_LATENCY_BEGIN(); \
+                                       UBaseType_t latencyUsis = heapWrapLock(); heapLatencyNested++
+    #define HEAP_LATENCY_ENTRY_END(op) heapLatencyNested--; heapWrapUnlock(latencyUsis); HEAP_LATENCY_END(op)
+
+    //! Copy latency statistics for all operations (pxStats may be NULL), optionally resetting them.
+    //! Resetting also enables the cycle counter, so call once at startup with xReset pdTRUE.
+    void vPortHeapLatencySnapshot( HeapLatencyStats_t pxStats[eHeapOpCount], BaseType_t xReset ) {
+      UBaseType_t usis = heapWrapLock();
+      if(pxStats) memcpy(pxStats, heapLatency, sizeof(heapLatency));
+      if(xReset) {
+        memset(heapLatency, 0, sizeof(heapLatency));
+        configHEAP_LATENCY_CYCLES_INIT();
+      }
+      heapWrapUnlock(usis);
+    }
+  #else
+    #define HEAP_LATENCY_BEGIN()
+    #define HEAP_LATENCY_END(op)
+    #define HEAP_LATENCY_ENTRY_BEGIN()
+    #define HEAP_LATENCY_ENTRY_END(op)
+  #endif
+
+  #if (defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING) || (defined(configHEAP_REDZONE) && configHEAP_REDZONE)
+    #define HEAP_BLOCK_HEADER 1
+    // Header preceding each block handed out by an outermost wrapper
+    typedef struct {
+      #if defined(configHEAP_REDZONE) && configHEAP_REDZONE
+        TaskHandle_t owner; // allocating task (NULL: ISR or before scheduler started)
+        uint32_t size;      // size requested by application
+      #endif
+      uint16_t slot;        // heapTaskUsage index of owning task
+      uint16_t generation;  // slot's generation when allocated
+      uint32_t offset;      // from start of newlib's block to application's pointer (larger for memalign)
+      #if defined(configHEAP_REDZONE) && configHEAP_REDZONE
+        uint8_t redzone[HEAP_REDZONE_SIZE]; // head canary
+      #endif
+    } heapBlockHeader_t;    // multiple of 8 bytes preserves newlib's 8-byte alignment
+    #define HEAP_BLOCK_HEADER_SIZE sizeof(heapBlockHeader_t)
+    static heapBlockHeader_t *heapBlockHeader(void *p) { return (heapBlockHeader_t *)p - 1; }
+  #else
+    #define HEAP_BLOCK_HEADER_SIZE 0
+  #endif
+  #define HEAP_BLOCK_OVERHEAD (HEAP_BLOCK_HEADER_SIZE+HEAP_REDZONE_SIZE) // header plus tail canary
+  //! Task on whose behalf an outermost wrapper allocates.
+  static int heapOwnerSlot(void) {
+    #if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING
+      return heapCurrentTaskSlot();
+    #else
+      return 0;
+    #endif
+  }
+  //! May this owner allocate nbytes (plus header)? Sets ENOMEM if not.
+  static bool heapAllocPermitted(void *reent, int slot, size_t nbytes) {
+    bool permitted = nbytes < ((size_t)-1)/2; // also prevents header overflow
+    #if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING
+      size_t quota = heapTaskUsage[slot].quota;
+      if(permitted && quota && (heapTaskUsage[slot].liveBytes + nbytes + HEAP_BLOCK_HEADER_SIZE > quota)) {
+        heapTaskUsage[slot].quotaFailures++;
+        permitted = false;
+      }
+    #else
+      (void)slot;
+    #endif
+    if(!permitted) ((struct _reent *)reent)->_errno = ENOMEM;
+    return permitted;
+  }
+  //! Account for a block of nbytes newlib just provided (NULL if none), and return application's pointer.
+  static void *heapBlockAllocated(void *raw, size_t offset, size_t nbytes, int slot) {
+    if(raw == NULL) return NULL;
+    size_t usable = malloc_usable_size(raw);
+    HeapBytesInUse += usable;
+    #if defined(HEAP_BLOCK_HEADER)
+      heapBlockHeader_t *h = heapBlockHeader((char *)raw + offset);
+      h->slot = (uint16_t)slot;
+      h->generation = 0;
+      h->offset = (uint32_t)offset;
+    #endif
+    #if defined(configHEAP_REDZONE) && configHEAP_REDZONE
+      h->owner = (xTaskGetSchedulerState()==taskSCHEDULER_NOT_STARTED || xPortIsInsideInterrupt()) ?
+                 NULL : xTaskGetCurrentTaskHandle();
+      h->size = (uint32_t)nbytes;
+      memset(h->redzone, HEAP_REDZONE_FILL, HEAP_REDZONE_SIZE);
+      memset((char *)raw + offset + nbytes, HEAP_REDZONE_FILL, HEAP_REDZONE_SIZE);
+    #else
+      (void)nbytes;
+    #endif
+    #if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING
+      h->generation = heapTaskUsage[slot].generation;
+      heapTaskUsage[slot].liveBytes += usable;
+      if(heapTaskUsage[slot].liveBytes > heapTaskUsage[slot].peakBytes) {
+        heapTaskUsage[slot].peakBytes = heapTaskUsage[slot].liveBytes;
+      }
+    #else
+      (void)slot;
+    #endif
+    #if defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS
+      heapLeakInsert((char *)raw + offset, usable - offset, heapBlockPC);
+    #endif
+    return (char *)raw + offset;
+  }
+  #if defined(configHEAP_REDZONE) && configHEAP_REDZONE // DRN redzone debug mode
+    //! First damaged canary byte of an application's block, or NULL if intact.
+    static void *heapRedzoneDamage(void *p) {
+      heapBlockHeader_t *h = heapBlockHeader(p);
+      for(int i=0; i<HEAP_REDZONE_SIZE; i++) {
+        if(h->redzone[i] != HEAP_REDZONE_FILL) return &h->redzone[i];
+      }
+      if(h->offset < HEAP_BLOCK_HEADER_SIZE ||
+         (size_t)h->offset + h->size + HEAP_REDZONE_SIZE > malloc_usable_size((char *)p - h->offset)) return &h->size;
+      uint8_t *tail = (uint8_t *)p + h->size;
+      for(int i=0; i<HEAP_REDZONE_SIZE; i++) {
+        if(tail[i] != HEAP_REDZONE_FILL) return &tail[i];
+      }
+      return NULL;
+    }
+  #endif
+  #if (defined(configHEAP_BOOT_ARENA) && configHEAP_BOOT_ARENA) || (defined(configHEAP_LIFETIME) && configHEAP_LIFETIME) || \
+      (defined(configHEAP_BOOT_RECORD) && configHEAP_BOOT_RECORD) || (defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN)
+    #define HEAP_BOOT_BLOCKS 1
+    // Boot blocks are bump-allocated by outermost wrappers, from the boot arena, from frozen storage, or
+    // (lifetime hint permanent) from the top of the heap. They are permanent: free ignores them, and
+    // realloc moves a grown block to newlib's heap. They are not counted in HeapBytesInUse or task accounting.
+    #define HEAP_BOOT_HEADER 8 // holds application's size; keeps 8-byte alignment
+    static size_t heapBootBlockSize(const void *p) { return *(const size_t *)((const char *)p - HEAP_BOOT_HEADER); }
+  #endif
+  #if (defined(configHEAP_BOOT_ARENA) && configHEAP_BOOT_ARENA) || (defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN)
+    //! Bump-allocate nbytes aligned to align (0 for default) from *pNext up to limit; NULL if no room.
+    static void *heapBumpAllocate(char **pNext, char *limit, size_t align, size_t nbytes) {
+        if(align < 8) align = 8;
+        uintptr_t p = ((uintptr_t)*pNext + HEAP_BOOT_HEADER + align-1) & ~(uintptr_t)(align-1);
+        size_t rounded = (nbytes + 7) & ~(size_t)7;
+        if(p > (uintptr_t)limit || rounded > (uintptr_t)limit - p || nbytes > rounded) return NULL;
+        *(size_t *)(p - HEAP_BOOT_HEADER) = nbytes;
+        *pNext = (char *)(p + rounded);
+        return (void *)p;
+    }
+  #endif
+  #if defined(configHEAP_BOOT_ARENA) && configHEAP_BOOT_ARENA // DRN boot-time arena
+    // Until the scheduler starts, outermost wrappers allocate from a bump arena between linker symbols
+    // __HeapBootBase and __HeapBootLimit rather than from newlib's heap. Allocation is O(1) and can't
+    // collide with the boot stack. When the arena is full, allocations fall back to newlib.
+    extern char __HeapBootBase, __HeapBootLimit; // make sure to define these symbols in linker command file
+    static char *heapBootNext = &__HeapBootBase; // first unused byte
+    //! Bytes of the boot arena used, and optionally its size (to tune the linker script).
+    size_t xPortGetBootArenaUsage( size_t *pxArenaSize ) {
+        if(pxArenaSize) *pxArenaSize = (size_t)(&__HeapBootLimit-&__HeapBootBase);
+        return (size_t)(heapBootNext-&__HeapBootBase);
+    }
+  #endif
+  #if (defined(configHEAP_BOOT_RECORD) && configHEAP_BOOT_RECORD) || (defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN)
+    // DRN record-and-freeze: allocations made before the application calls vPortHeapBootComplete are
+    // boot allocations. configHEAP_BOOT_RECORD records each one's call site, size and alignment;
+    // vPortHeapBootRecordDump outputs them for a host script that generates statically sized storage
+    // (see README.md). With configHEAP_BOOT_FROZEN, the generated storage serves boot allocations in the
+    // order recorded. Order, not call-site address, identifies a boot allocation, so storage remains
+    // valid as code moves between builds. If an allocation doesn't match the recording (different size
+    // or alignment), boot allocations from then on come from the heap; compare HeapFrozenBlocksServed
+    // with xHeapFrozenBlockCount to see when the storage needs regenerating.
+    static bool heapBootCompleted;
+    static uint32_t heapBootAllocations; // boot allocations so far
+    //! Mark the end of boot: later allocations are neither recorded nor served from frozen storage.
+    void vPortHeapBootComplete( void ) { heapBootCompleted = true; }
+  #endif
+  #if defined(configHEAP_BOOT_RECORD) && configHEAP_BOOT_RECORD // DRN record boot allocations
+    typedef struct {
+      void *pc;           // allocation call site
+      uint32_t size;      // requested
+      uint32_t align;     // 0: default alignment
+    } heapBootRecord_t;
+    static heapBootRecord_t heapBootRecords[configHEAP_BOOT_RECORD];
+    //! Output recorded boot allocations, one line each, in allocation order.
+    void vPortHeapBootRecordDump( void (*pfnOutput)( const char *pcLine ) ) {
+      char line[64];
+      UBaseType_t usis = heapWrapLock();
+      uint32_t count = heapBootAllocations;
+      heapWrapUnlock(usis);
+      for(uint32_t i=0; i<count && i<configHEAP_BOOT_RECORD; i++) {
+        heapBootRecord_t r = heapBootRecords[i]; // entries below count no longer change
+        snprintf(line, sizeof(line), "heapboot %p %lu %lu\n", r.pc, (unsigned long)r.size, (unsigned long)r.align);
+        pfnOutput(line);
+      }
+      snprintf(line, sizeof(line), "heapboot end %lu%s\n", (unsigned long)count,
+               (count > configHEAP_BOOT_RECORD) ? " (overflow: increase configHEAP_BOOT_RECORD)" : "");
+      pfnOutput(line);
+    }
+  #endif
+  #if defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN // DRN serve boot allocations from generated storage
+    static char *heapFrozenNext = (char *)ullHeapFrozenStorage; // first unused byte
+    static bool heapFrozenDiverged; // allocation didn't match recording
+    uint32_t HeapFrozenBlocksServed;
+  #endif
+  #if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME // DRN lifetime-segregated allocation
+    // dlmalloc interleaves long-lived and transient blocks, so blocks that are never freed leave holes
+    // that are never filled. Permanent blocks are instead bump-allocated downward from the top of the
+    // heap (newlib's heap grows up to meet them): O(1), no header beyond the size, never freed.
+    // Each task's hint is kept in its thread-local storage pointer configHEAP_LIFETIME_TLS_INDEX
+    // (NULL: eHeapLifetimeLong). Before the scheduler starts, one boot hint applies.
+    #ifndef configHEAP_LIFETIME_TLS_INDEX
+      #error "configHEAP_LIFETIME_TLS_INDEX must specify a thread-local storage pointer reserved for lifetime hints"
+    #endif
+    #if configHEAP_LIFETIME_TLS_INDEX >= configNUM_THREAD_LOCAL_STORAGE_POINTERS
+      #error "configHEAP_LIFETIME_TLS_INDEX must be less than configNUM_THREAD_LOCAL_STORAGE_POINTERS"
+    #endif
+    static eHeapLifetime heapLifetimeBootHint = eHeapLifetimeLong; // before scheduler starts
+    static eHeapLifetime heapLifetimeHint(void) {
+        if(xTaskGetSchedulerState()==taskSCHEDULER_NOT_STARTED) return heapLifetimeBootHint;
+        if(xPortIsInsideInterrupt()) return eHeapLifetimeLong;
+        return (eHeapLifetime)(intptr_t)pvTaskGetThreadLocalStoragePointer(NULL, configHEAP_LIFETIME_TLS_INDEX);
+    }
+    //! Bump-allocate nbytes aligned to align (0 for default) downward from the top of the heap; NULL if no room.
+    static void *heapPermanentAllocate(size_t align, size_t nbytes) {
+        if(align < 8) align = 8;
+        size_t rounded = (nbytes + 7) & ~(size_t)7;
+        void *p = NULL;
+        UBaseType_t usis = heapWrapLock();
+        uintptr_t floor = (uintptr_t)heapPermanentFloor;
+        #if HEAP_BOARD_SP_LIMIT_BEFORE_SCHEDULER
+          // Until the scheduler starts, the boot stack may reach below the heap limit. Permanent blocks are contiguous
+          // from the top of the heap, so none fit once the stack is below the lowest of them.
+          if(xTaskGetSchedulerState()==taskSCHEDULER_NOT_STARTED && (uintptr_t)stack_ptr < floor) floor = 0;
+        #endif
+        uintptr_t lowest = (uintptr_t)currentHeapEnd + HEAP_BOOT_HEADER;
+        #if defined(configHEAP_RESERVE_BYTES) && configHEAP_RESERVE_BYTES // DRN emergency reserve
+          if(!heapReserveReleased) lowest += configHEAP_RESERVE_BYTES; // reserve stays at top of newlib's heap
+        #endif
+        if(nbytes <= rounded && rounded <= floor && floor - rounded >= lowest) {
+            uintptr_t user = (floor - rounded) & ~(uintptr_t)(align-1);
+            if(user >= lowest) {
+                *(size_t *)(user - HEAP_BOOT_HEADER) = nbytes;
+                heapPermanentFloor = (char *)(user - HEAP_BOOT_HEADER);
+                p = (void *)user;
+            }
+        }
+        heapWrapUnlock(usis);
+        return p;
+    }
+    //! Lifetime hint for the calling task's subsequent malloc-family calls (permanent or long); returns
+    //! the previous hint. For example, set permanent around driver initialization.
+    eHeapLifetime xPortHeapSetLifetime( eHeapLifetime eLifetime ) {
+        configASSERT( !xPortIsInsideInterrupt() );
+        eHeapLifetime previous = heapLifetimeHint();
+        if(xTaskGetSchedulerState()==taskSCHEDULER_NOT_STARTED) {
+            heapLifetimeBootHint = eLifetime;
+        } else {
+            vTaskSetThreadLocalStoragePointer(NULL, configHEAP_LIFETIME_TLS_INDEX, (void *)(intptr_t)eLifetime);
+        }
+        return previous;
+    }
+    //! Bytes used by permanent blocks (including headers).
+    size_t xPortGetPermanentHeapUsage( void ) {
+        return (size_t)(heapLimit - heapPermanentFloor);
+    }
+  #endif
+  #if defined(HEAP_BOOT_BLOCKS)
+    static bool heapIsBootBlock(const void *p) {
+      #if defined(configHEAP_BOOT_ARENA) && configHEAP_BOOT_ARENA
+        if((const char *)p >= &__HeapBootBase && (const char *)p < &__HeapBootLimit) return true;
+      #endif
+      #if defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN
+        if((const char *)p >= (const char *)ullHeapFrozenStorage &&
+           (const char *)p < (const char *)ullHeapFrozenStorage + xHeapFrozenStorageSize) return true;
+      #endif
+      #if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME
+        if((const char *)p > heapPermanentFloor && (const char *)p < heapLimit) return true;
+      #endif
+      (void)p;
+      return false;
+    }
+    //! Called by outermost wrappers for every allocation: record it if still booting, and serve it from
+    //! frozen storage or the boot arena if possible (align 0 for default). NULL: allocate from newlib.
+    static void *heapBootAllocate(size_t align, size_t nbytes) {
+      void *p = NULL;
+      #if (defined(configHEAP_BOOT_RECORD) && configHEAP_BOOT_RECORD) || (defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN)
+        if(!heapBootCompleted) {
+          uint32_t n = heapBootAllocations++;
+          #if defined(configHEAP_BOOT_RECORD) && configHEAP_BOOT_RECORD
+            if(n < configHEAP_BOOT_RECORD) {
+              heapBootRecords[n].pc = heapBlockPC;
+              heapBootRecords[n].size = (uint32_t)nbytes;
+              heapBootRecords[n].align = (uint32_t)align;
+            }
+          #endif
+          #if defined(configHEAP_BOOT_FROZEN) && configHEAP_BOOT_FROZEN
+            if(!heapFrozenDiverged && n < xHeapFrozenBlockCount) {
+              if(xHeapFrozenBlocks[n].size == nbytes && xHeapFrozenBlocks[n].align == align) {
+                p = heapBumpAllocate(&heapFrozenNext, (char *)ullHeapFrozenStorage + xHeapFrozenStorageSize, align, nbytes);
+              }
+              if(p) HeapFrozenBlocksServed++;
+              else heapFrozenDiverged = true;
+            }
+          #endif
+        }
+      #endif
+      #if defined(configHEAP_BOOT_ARENA) && configHEAP_BOOT_ARENA
+        if(p == NULL && xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+          p = heapBumpAllocate(&heapBootNext, &__HeapBootLimit, align, nbytes);
+        }
+      #endif
+      #if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME
+        if(p == NULL && heapLifetimeHint() == eHeapLifetimePermanent) {
+          p = heapPermanentAllocate(align, nbytes);
+        }
+      #endif
+      return p;
+    }
+  #endif
+  #if (defined(configHEAP_ALLOC_STATS) && configHEAP_ALLOC_STATS) || defined(HEAP_BLOCK_HEADER)
+  //! Size application may use in its block.
+  static size_t heapBlockSize(void *p) {
+    #if defined(HEAP_BOOT_BLOCKS)
+      if(heapIsBootBlock(p)) return heapBootBlockSize(p);
+    #endif
+    #if defined(configHEAP_REDZONE) && configHEAP_REDZONE
+      return heapBlockHeader(p)->size;
+    #elif defined(HEAP_BLOCK_HEADER)
+      return malloc_usable_size((char *)p - heapBlockHeader(p)->offset) - heapBlockHeader(p)->offset;
+    #else
+      return malloc_usable_size(p);
+    #endif
+  }
+  #endif
+  //! Account for release of an application's block. Returns newlib's pointer (NULL if the block is damaged
+  //! and must not be freed), and owner's slot (-1 if the owner was deleted).
+  static void *heapBlockReleasing(void *p, int *pSlot) {
+    #if defined(configHEAP_REDZONE) && configHEAP_REDZONE
+      void *damage = heapRedzoneDamage(p);
+      if(damage) {
+        if(heapCorruptAddress == NULL) heapCorruptAddress = damage;
+        return NULL;
+      }
+    #endif
+    #if defined(HEAP_BLOCK_HEADER)
+      heapBlockHeader_t *h = heapBlockHeader(p);
+      void *raw = (char *)p - h->offset;
+    #else
+      void *raw = p;
+    #endif
+    size_t usable = malloc_usable_size(raw);
+    int slot = 0;
+    #if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING
+      slot = h->slot;
+      if(slot >= configHEAP_TASK_ACCOUNTING_MAX_TASKS || h->generation != heapTaskUsage[slot].generation) {
+        slot = -1; // owner deleted (or header trashed); don't credit anyone
+      } else {
+        heapTaskUsage[slot].liveBytes -= usable;
+      }
+    #endif
+    HeapBytesInUse -= usable;
+    #if defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS
+      heapLeakRemove(p);
+    #endif
+    if(pSlot) *pSlot = slot;
+    return raw;
+  }
+  //! Undo heapBlockReleasing for a block that stays allocated (realloc failed): charge it to its
+  //! original owner again (none if slot < 0). Its header is unchanged.
+  static void heapBlockKept(void *raw, int slot) {
+    size_t usable = malloc_usable_size(raw);
+    HeapBytesInUse += usable;
+    #if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING
+      if(slot >= 0) heapTaskUsage[slot].liveBytes += usable;
+    #else
+      (void)slot;
+    #endif
+  }
+  #if (defined(configHEAP_REDZONE) && configHEAP_REDZONE) && configHEAP_REDZONE_QUARANTINE_BLOCKS // DRN redzone debug mode
+    static void *heapQuarantine[configHEAP_REDZONE_QUARANTINE_BLOCKS]; // poisoned application blocks, FIFO
+    static int heapQuarantineNext;
+    //! Check quarantined block wasn't written after free, and give it back to newlib.
+    static void heapQuarantineRelease(void *reent, void *p) {
+      extern void __real__free_r(void *reent, void *ptr);
+      void *damage = heapRedzoneDamage(p);
+      for(uint32_t i=0; !damage && i<heapBlockHeader(p)->size; i++) {
+        if(((uint8_t *)p)[i] != HEAP_POISON_FILL) damage = (uint8_t *)p + i;
+      }
+      if(damage) {
+        if(heapCorruptAddress == NULL) heapCorruptAddress = damage;
+        return; // don't let newlib reuse a damaged block
+      }
+      __real__free_r(reent, (char *)p - heapBlockHeader(p)->offset);
+    }
+    //! Release all quarantined blocks (when memory runs out). Returns false if quarantine was empty.
+    static bool heapQuarantineFlush(void *reent) {
+      bool released = false;
+      for(int i=0; i<configHEAP_REDZONE_QUARANTINE_BLOCKS; i++) {
+        if(heapQuarantine[i]) {
+          heapQuarantineRelease(reent, heapQuarantine[i]);
+          heapQuarantine[i] = NULL;
+          released = true;
+        }
+      }
+      return released;
+    }
+  #endif
+  //! Outermost malloc: allocate with header for this owner.
+  static void *heapMalloc(void *reent, size_t nbytes) {
+    extern void * __real__malloc_r(void *reent,size_t nbytes);
+    #if defined(HEAP_BOOT_BLOCKS)
+      void *boot = heapBootAllocate(0, nbytes);
+      if(boot) return boot;
+    #endif
+    int slot = heapOwnerSlot();
+    void *raw = heapAllocPermitted(reent,slot,nbytes) ? __real__malloc_r(reent, nbytes+HEAP_BLOCK_OVERHEAD) : NULL;
+    #if (defined(configHEAP_REDZONE) && configHEAP_REDZONE) && configHEAP_REDZONE_QUARANTINE_BLOCKS
+      if(raw == NULL && heapAllocPermitted(reent,slot,nbytes) && heapQuarantineFlush(reent)) {
+        raw = __real__malloc_r(reent, nbytes+HEAP_BLOCK_OVERHEAD);
+      }
+    #endif
+    return heapBlockAllocated(raw, HEAP_BLOCK_HEADER_SIZE, nbytes, slot);
+  }
+  #if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE
+    static int heapObjectUntrack(const void *p); // block released or resized: no longer a cache block
+  #endif
+  //! Outermost free.
+  static void heapFree(void *reent, void *ptr) {
+    extern void __real__free_r(void *reent, void *ptr);
+    #if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE
+      (void)heapObjectUntrack(ptr);
+    #endif
+    #if defined(HEAP_BOOT_BLOCKS)
+      if(heapIsBootBlock(ptr)) return; // permanent
+    #endif
+    void *raw = ptr ? heapBlockReleasing(ptr,NULL) : NULL;
+    if(raw == NULL) return;
+    #if (defined(configHEAP_REDZONE) && configHEAP_REDZONE) && configHEAP_REDZONE_QUARANTINE_BLOCKS
+      memset(ptr, HEAP_POISON_FILL, heapBlockHeader(ptr)->size);
+      void *oldest = heapQuarantine[heapQuarantineNext];
+      heapQuarantine[heapQuarantineNext] = ptr;
+      heapQuarantineNext = (heapQuarantineNext+1) % configHEAP_REDZONE_QUARANTINE_BLOCKS;
+      if(oldest) heapQuarantineRelease(reent, oldest);
+    #else
+      __real__free_r(reent, raw);
+    #endif
+  }
+
+  void *__wrap_malloc(size_t nbytes) {
+    extern void * __real_malloc(size_t nbytes);
+    HEAP_ATOMIC_ADD(MallocCallCnt, 1);
+    HEAP_ATOMIC_ADD(TotalMallocdBytes, nbytes);
+    HEAP_NOTE_CALLER_BEGIN();
+    inside_malloc = true;
+      void *p = __real_malloc(nbytes); // will call malloc_r...
+    inside_malloc = false;
+    HEAP_NOTE_CALLER_END();
+    return p;
+  }
+  void *__wrap__malloc_r(void *reent, size_t nbytes) {
+    extern void * __real__malloc_r(void *reent,size_t nbytes);
+    if(!inside_malloc) {
+      HEAP_ATOMIC_ADD(MallocCallCnt, 1);
+      HEAP_ATOMIC_ADD(TotalMallocdBytes, nbytes);
+    }
+    HEAP_LATENCY_BEGIN();
+    UBaseType_t usis = heapWrapEnter();
+    HEAP_NOTE_BLOCK_PC();
+    void *p = (heapWrapDepth > 1) ? __real__malloc_r(reent,nbytes) : heapMalloc(reent,nbytes);
+    if(heapWrapDepth == 1) HEAP_STATS_ALLOCATION(nbytes);
+    heapWrapExit(usis);
+    HEAP_LATENCY_END(eHeapOpMalloc);
+    return p;
+  }
+  void __wrap__free_r(void *reent, void *ptr) {
+    extern void __real__free_r(void *reent, void *ptr);
+    HEAP_LATENCY_BEGIN();
+    UBaseType_t usis = heapWrapEnter();
+    if(heapWrapDepth > 1) __real__free_r(reent,ptr);
+    else heapFree(reent,ptr);
+    heapWrapExit(usis);
+    HEAP_LATENCY_END(eHeapOpFree);
+  }
+  void *__wrap__realloc_r(void *reent, void *ptr, size_t nbytes) {
+    extern void * __real__realloc_r(void *reent, void *ptr, size_t nbytes);
+    HEAP_LATENCY_BEGIN();
+    UBaseType_t usis = heapWrapEnter();
+    HEAP_NOTE_BLOCK_PC();
+    #if defined(configHEAP_ALLOC_STATS) && configHEAP_ALLOC_STATS
+      size_t statsOldSize = (heapWrapDepth == 1 && ptr) ? heapBlockSize(ptr) : 0;
+    #endif
+    #if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE
+      if(heapWrapDepth == 1) (void)heapObjectUntrack(ptr);
+    #endif
+    void *p;
+    if(heapWrapDepth > 1) {
+      p = __real__realloc_r(reent,ptr,nbytes);
+    } else if(ptr == NULL) {
+      p = heapMalloc(reent,nbytes);
+    #if defined(HEAP_BOOT_BLOCKS)
+    } else if(heapIsBootBlock(ptr)) { // boot block stays in place: shrink in place, grow by copying
+      size_t oldSize = heapBootBlockSize(ptr);
+      p = (nbytes <= oldSize) ? ptr : heapMalloc(reent,nbytes);
+      if(p && p != ptr) memcpy(p, ptr, oldSize);
+    #endif
+    #if defined(configHEAP_REDZONE) && configHEAP_REDZONE
+    } else if((heapCorruptAddress = heapRedzoneDamage(ptr)) != NULL) {
+      p = NULL; // don't copy from (or free) a damaged block
+    #endif
+    #if defined(HEAP_BLOCK_HEADER)
+    } else if((HEAP_REDZONE_SIZE != 0) || (heapBlockHeader(ptr)->offset != HEAP_BLOCK_HEADER_SIZE)) {
+      // memalign'd block: newlib's realloc won't preserve alignment, so move it ourselves.
+      // Redzone mode always moves, so stale pointers to the old block land in quarantine.
+      size_t oldSize = heapBlockSize(ptr);
+      p = heapMalloc(reent,nbytes);
+      if(p) {
+        memcpy(p, ptr, (oldSize < nbytes) ? oldSize : nbytes);
+        heapFree(reent,ptr);
+      }
+    #endif
+    } else if(nbytes == 0 && HEAP_BLOCK_OVERHEAD == 0) {
+      heapFree(reent,ptr); // newlib's realloc(ptr,0) frees ptr and returns NULL: not a failure
+      p = NULL;
+    } else {
+      int slot;
+      #if defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS
+        heapLeakEntry_t leak; // original owner and call site, restored if realloc fails
+        bool leakRecorded = heapLeakFind(ptr, &leak);
+      #endif
+      void *raw = heapBlockReleasing(ptr,&slot);
+      int newSlot = (slot < 0) ? 0 : slot; // owner deleted: new block belongs to system
+      void *newRaw = heapAllocPermitted(reent,newSlot,nbytes) ?
+                     __real__realloc_r(reent, raw, nbytes+HEAP_BLOCK_OVERHEAD) : NULL;
+      p = heapBlockAllocated(newRaw, HEAP_BLOCK_HEADER_SIZE, nbytes, newSlot);
+      if(p == NULL) { // failed: original block remains, as it was
+        heapBlockKept(raw, slot);
+        #if defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS
+          heapLeakEntry_t *e = leakRecorded ? heapLeakNewEntry(ptr) : NULL;
+          if(e) *e = leak;
+        #endif
+      }
+    }
+    #if defined(configHEAP_ALLOC_STATS) && configHEAP_ALLOC_STATS
+      if(heapWrapDepth == 1 && ptr == NULL) heapStatsAllocation(nbytes);
+      else if(heapWrapDepth == 1 && p) heapStatsRealloc(statsOldSize, nbytes, p != ptr);
+    #endif
+    heapWrapExit(usis);
+    HEAP_LATENCY_END(eHeapOpRealloc);
+    return p;
+  }
+  void *__wrap__memalign_r(void *reent, size_t align, size_t nbytes) {
+    extern void * __real__memalign_r(void *reent, size_t align, size_t nbytes);
+    UBaseType_t usis = heapWrapEnter();
+    HEAP_NOTE_BLOCK_PC();
+    void *p;
+    if(heapWrapDepth > 1) {
+      p = __real__memalign_r(reent,align,nbytes);
+    } else {
+      // header must be followed by an aligned application pointer
+      size_t offset = align ? ((HEAP_BLOCK_HEADER_SIZE+align-1)/align)*align : HEAP_BLOCK_HEADER_SIZE;
+      int slot = heapOwnerSlot();
+      #if defined(HEAP_BOOT_BLOCKS)
+        p = heapBootAllocate(align, nbytes);
+        if(p == NULL)
+      #endif
+      {
+        void *raw = heapAllocPermitted(reent,slot,nbytes+offset) ?
+                    __real__memalign_r(reent, align, nbytes+offset+HEAP_REDZONE_SIZE) : NULL;
+        p = heapBlockAllocated(raw, offset, nbytes, slot);
+      }
+      HEAP_STATS_ALLOCATION(nbytes);
+    }
+    heapWrapExit(usis);
+    return p;
+  }
+  void *__wrap__calloc_r(void *reent, size_t n, size_t size) {
+    extern void * __real__calloc_r(void *reent, size_t n, size_t size);
+    UBaseType_t usis = heapWrapEnter();
+    HEAP_NOTE_BLOCK_PC();
+    void *p;
+    if(heapWrapDepth > 1) {
+      p = __real__calloc_r(reent,n,size);
+    } else {
+      size_t nbytes = n*size;
+      int slot = heapOwnerSlot();
+      bool overflow = (size != 0) && (nbytes/size != n);
+      #if defined(HEAP_BOOT_BLOCKS)
+        p = overflow ? NULL : heapBootAllocate(0, nbytes);
+        if(p) memset(p, 0, nbytes); // arena isn't zeroed by startup code
+        else
+      #endif
+      {
+        void *raw = (!overflow && heapAllocPermitted(reent,slot,nbytes)) ?
+                    __real__calloc_r(reent, 1, nbytes+HEAP_BLOCK_OVERHEAD) : NULL;
+        if(overflow) ((struct _reent *)reent)->_errno = ENOMEM;
+        p = heapBlockAllocated(raw, HEAP_BLOCK_HEADER_SIZE, nbytes, slot);
+      }
+      HEAP_STATS_ALLOCATION(nbytes);
+    }
+    heapWrapExit(usis);
+    return p;
+  }
+  size_t __wrap__malloc_usable_size_r(void *reent, void *ptr) {
+    extern size_t __real__malloc_usable_size_r(void *reent, void *ptr);
+    #if defined(HEAP_BOOT_BLOCKS)
+      if(heapIsBootBlock(ptr)) return heapBootBlockSize(ptr);
+    #endif
+    #if defined(HEAP_BLOCK_HEADER)
+      if(ptr && heapWrapDepth == 0) { // application's pointer: exclude header (and canary)
+        #if defined(configHEAP_REDZONE) && configHEAP_REDZONE
+          return heapBlockHeader(ptr)->size;
+        #else
+          size_t offset = heapBlockHeader(ptr)->offset;
+          return __real__malloc_usable_size_r(reent, (char *)ptr - offset) - offset;
+        #endif
+      }
+    #endif
+    return __real__malloc_usable_size_r(reent,ptr);
+  }
+#endif
+
+#if defined(HEAP_REGIONS) // DRN memory regions outside newlib's heap (DMA, fast memory)
+  // Each region is a block of memory defined by linker symbols (just like __HeapBase..__HeapLimit
+  // for newlib's heap), managed by a small first-fit allocator: an address-ordered free list,
+  // coalesced on free. Region blocks are freed by vPortFree, which recognizes them by address
+  // (newlib's free knows nothing of these regions). They are not counted in HeapBytesInUse,
+  // task accounting, or the leak detector.
+  typedef struct heapRegionBlock {
+      size_t size;                  // including this header; multiple of HEAP_REGION_GRANULE
+      union {
+          struct heapRegionBlock *next; // while free: next free block at a higher address
+          uintptr_t magic;              // while allocated: HEAP_REGION_MAGIC ^ block address
+      };
+  } heapRegionBlock_t;
+  #define HEAP_REGION_GRANULE   8 // block sizes and addresses, so applications get 8-byte alignment
+  #define HEAP_REGION_HEADER    sizeof(heapRegionBlock_t) // precedes application's block
+  #define HEAP_REGION_MIN_BLOCK (HEAP_REGION_HEADER+HEAP_REGION_GRANULE) // smaller remnants stay in allocated block
+  #define HEAP_REGION_MAGIC     0x5245474EUL
+  typedef struct {
+      char *base, *limit;           // from linker; NULL if region not configured
+      heapRegionBlock_t *freeList;
+      size_t freeBytes, minFreeBytes;
+      bool initialized;
+  } heapRegion_t;
+  #if defined(configHEAP_REGION_DMA) && configHEAP_REGION_DMA
+    extern char __HeapDmaBase, __HeapDmaLimit;   // make sure to define these symbols in linker command file
+  #endif
+  #if defined(configHEAP_REGION_FAST) && configHEAP_REGION_FAST
+    extern char __HeapFastBase, __HeapFastLimit; // make sure to define these symbols in linker command file
+  #endif
+  #if defined(configHEAP_REGION_BULK) && configHEAP_REGION_BULK
+    extern char __HeapBulkBase, __HeapBulkLimit; // make sure to define these symbols in linker command file
+  #endif
+  #if defined(configHEAP_REGION_TRANSIENT) && configHEAP_REGION_TRANSIENT
+    extern char __HeapTransientBase, __HeapTransientLimit; // make sure to define these symbols in linker command file
+  #endif
+  static heapRegion_t heapRegions[eHeapRegionCount] = {
+    #if defined(configHEAP_REGION_DMA) && configHEAP_REGION_DMA
+      [eHeapRegionDma]  = { &__HeapDmaBase,  &__HeapDmaLimit  },
+    #endif
+    #if defined(configHEAP_REGION_FAST) && configHEAP_REGION_FAST
+      [eHeapRegionFast] = { &__HeapFastBase, &__HeapFastLimit },
+    #endif
+    #if defined(configHEAP_REGION_BULK) && configHEAP_REGION_BULK
+      [eHeapRegionBulk] = { &__HeapBulkBase, &__HeapBulkLimit },
+    #endif
+    #if defined(configHEAP_REGION_TRANSIENT) && configHEAP_REGION_TRANSIENT
+      [eHeapRegionTransient] = { &__HeapTransientBase, &__HeapTransientLimit },
+    #endif
+  };
+  static void heapRegionInit(heapRegion_t *r) { // called with heap locked
+      uintptr_t base  = ((uintptr_t)r->base + HEAP_REGION_GRANULE-1) & ~(uintptr_t)(HEAP_REGION_GRANULE-1);
+      uintptr_t limit = (uintptr_t)r->limit & ~(uintptr_t)(HEAP_REGION_GRANULE-1);
+      r->initialized = true;
+      if(limit < base + HEAP_REGION_MIN_BLOCK) return; // region too small to use
+      r->freeList = (heapRegionBlock_t *)base;
+      r->freeList->size = limit - base;
+      r->freeList->next = NULL;
+      r->freeBytes = r->minFreeBytes = limit - base;
+  }
+  static void *heapRegionAllocate(heapRegion_t *r, size_t xAlignment, size_t xSize) {
+      if(xAlignment < HEAP_REGION_GRANULE) xAlignment = HEAP_REGION_GRANULE;
+      configASSERT( (xAlignment & (xAlignment-1)) == 0 ); // must be a power of two
+      if(r->base == NULL || xSize > (size_t)(r->limit-r->base)) return NULL;
+      size_t need = HEAP_REGION_HEADER + ((xSize + HEAP_REGION_GRANULE-1) & ~(size_t)(HEAP_REGION_GRANULE-1));
+      if(xSize == 0) need = HEAP_REGION_MIN_BLOCK;
+      void *p = NULL;
+      UBaseType_t usis = heapWrapLock();
+      if(!r->initialized) heapRegionInit(r);
+      for(heapRegionBlock_t **prev = &r->freeList, *b; (b = *prev) != NULL; prev = &b->next) {
+          // Place application's block on the requested alignment; leading gap must be usable as a free block.
+          uintptr_t user = ((uintptr_t)b + HEAP_REGION_HEADER + xAlignment-1) & ~(uintptr_t)(xAlignment-1);
+          while(user-HEAP_REGION_HEADER != (uintptr_t)b && user-HEAP_REGION_HEADER-(uintptr_t)b < HEAP_REGION_MIN_BLOCK) user += xAlignment;
+          size_t lead = user-HEAP_REGION_HEADER-(uintptr_t)b;
+          if(lead + need > b->size) continue;
+          if(lead) { // split off leading gap, which stays in the free list
+              heapRegionBlock_t *a = (heapRegionBlock_t *)((char *)b + lead);
+              a->size = b->size - lead;
+              a->next = b->next;
+              b->size = lead;
+              b->next = a;
+              prev = &b->next;
+              b = a;
+          }
+          if(b->size - need >= HEAP_REGION_MIN_BLOCK) { // split off unused tail
+              heapRegionBlock_t *t = (heapRegionBlock_t *)((char *)b + need);
+              t->size = b->size - need;
+              t->next = b->next;
+              b->size = need;
+              b->next = t;
+          }
+          *prev = b->next;
+          b->magic = HEAP_REGION_MAGIC ^ (uintptr_t)b;
+          r->freeBytes -= b->size;
+          if(r->freeBytes < r->minFreeBytes) r->minFreeBytes = r->freeBytes;
+          p = (char *)b + HEAP_REGION_HEADER;
+          break;
+      }
+      heapWrapUnlock(usis);
+      return p;
+  }
+  //! Region containing pv, or NULL if pv was allocated from newlib's heap.
+  static heapRegion_t *heapRegionOf(const void *pv) {
+      for(int i=0; i<eHeapRegionCount; i++) {
+          heapRegion_t *r = &heapRegions[i];
+          if(r->base && (const char *)pv >= r->base && (const char *)pv < r->limit) return r;
+      }
+      return NULL;
+  }
+  static heapRegionBlock_t *heapRegionBlock(const void *pv) {
+      heapRegionBlock_t *b = (heapRegionBlock_t *)((char *)pv - HEAP_REGION_HEADER);
+      configASSERT( b->magic == (HEAP_REGION_MAGIC ^ (uintptr_t)b) ); // double free or damaged header
+      return b;
+  }
+  static void heapRegionFree(heapRegion_t *r, void *pv) {
+      heapRegionBlock_t *b = heapRegionBlock(pv);
+      UBaseType_t usis = heapWrapLock();
+      r->freeBytes += b->size;
+      heapRegionBlock_t **prev = &r->freeList, *before = NULL;
+      while(*prev && *prev < b) { before = *prev; prev = &before->next; }
+      b->next = *prev;
+      *prev = b;
+      if(b->next && (char *)b + b->size == (char *)b->next) { // coalesce with following free block
+          b->size += b->next->size;
+          b->next = b->next->next;
+      }
+      if(before && (char *)before + before->size == (char *)b) { // coalesce with preceding free block
+          before->size += b->size;
+          before->next = b->next;
+      }
+      heapWrapUnlock(usis);
+  }
+
+  //! Allocate from a linker-defined memory region (not newlib's heap); NULL if the region is
+  //! not configured or has no room. xAlignment is a power of two (0 for default 8-byte alignment).
+  void *pvPortMallocRegion( eHeapRegion eRegion, size_t xAlignment, size_t xSize ) {
+      configASSERT( eRegion < eHeapRegionCount );
+      return heapRegionAllocate(&heapRegions[eRegion], xAlignment, xSize);
+  }
+  //! Free bytes in a region (including block headers), and optionally its minimum ever free.
+  size_t xPortGetRegionFreeSize( eHeapRegion eRegion, size_t *pxMinimumEverFree ) {
+      configASSERT( eRegion < eHeapRegionCount );
+      heapRegion_t *r = &heapRegions[eRegion];
+      UBaseType_t usis = heapWrapLock();
+      if(r->base && !r->initialized) heapRegionInit(r);
+      size_t freeBytes = r->freeBytes;
+      if(pxMinimumEverFree) *pxMinimumEverFree = r->minFreeBytes;
+      heapWrapUnlock(usis);
+      return freeBytes;
+  }
+#endif
+
+#if defined(configHEAP_BUDDY) && configHEAP_BUDDY // DRN buddy allocator for power-of-two buffers
+  // Binary buddy system in the linker-defined region __HeapBuddyBase..__HeapBuddyLimit. Requests are
+  // rounded up to a power of two from configHEAP_BUDDY_MIN_BLOCK to configHEAP_BUDDY_MAX_BLOCK, and
+  // each block is aligned to its own size. Blocks carry no header: the block tree is described by
+  // two bitmaps (node split, node on free list) kept at the top of the region, and a freed block's
+  // size is found by walking up to its first split ancestor. Allocate and free are O(log n) in the
+  // number of block sizes. Blocks are freed by vPortFree, which recognizes them by address; like
+  // region blocks, they are not counted in HeapBytesInUse, task accounting, or the leak detector.
+  #define HEAP_BUDDY_MIN_SHIFT  __builtin_ctz(configHEAP_BUDDY_MIN_BLOCK)
+  #define HEAP_BUDDY_TOP        (HEAP_BUDDY_ORDERS-1) // order of configHEAP_BUDDY_MAX_BLOCK blocks
+  typedef struct heapBuddyFree {
+      struct heapBuddyFree *next, *prev;
+  } heapBuddyFree_t;
+  static struct {
+      uint8_t *base, *limit;       // blocks (aligned to configHEAP_BUDDY_MAX_BLOCK); bitmaps follow
+      uint32_t *splitBits;         // per node: split into two buddies
+      uint32_t *freeBits;          // per node: on free list
+      uint32_t nodeIndex[HEAP_BUDDY_ORDERS]; // bitmap index of each order's first node
+      heapBuddyFree_t *freeList[HEAP_BUDDY_ORDERS];
+      size_t freeBytes, minFreeBytes;
+      uint32_t allocations, failures;
+      bool initialized;
+  } heapBuddy;
+  extern char __HeapBuddyBase, __HeapBuddyLimit; // make sure to define these symbols in linker command file
+
+  static uint32_t heapBuddyNode(uint8_t *b, int order) {
+      return heapBuddy.nodeIndex[order] + (uint32_t)((b - heapBuddy.base) >> (HEAP_BUDDY_MIN_SHIFT + order));
+  }
+  static bool heapBuddyBit(const uint32_t *bits, uint32_t n) { return (bits[n/32] >> (n%32)) & 1; }
+  static void heapBuddySetBit(uint32_t *bits, uint32_t n, bool v) {
+      if(v) bits[n/32] |= 1UL << (n%32); else bits[n/32] &= ~(1UL << (n%32));
+  }
+  static void heapBuddyPush(uint8_t *b, int order) {
+      heapBuddyFree_t *f = (heapBuddyFree_t *)b;
+      f->prev = NULL;
+      f->next = heapBuddy.freeList[order];
+      if(f->next) f->next->prev = f;
+      heapBuddy.freeList[order] = f;
+      heapBuddySetBit(heapBuddy.freeBits, heapBuddyNode(b, order), true);
+  }
+  static void heapBuddyRemove(uint8_t *b, int order) {
+      heapBuddyFree_t *f = (heapBuddyFree_t *)b;
+      if(f->prev) f->prev->next = f->next; else heapBuddy.freeList[order] = f->next;
+      if(f->next) f->next->prev = f->prev;
+      heapBuddySetBit(heapBuddy.freeBits, heapBuddyNode(b, order), false);
+  }
+  static void heapBuddyInit(void) { // called with heap locked
+      heapBuddy.initialized = true;
+      uint8_t *base  = (uint8_t *)(((uintptr_t)&__HeapBuddyBase + configHEAP_BUDDY_MAX_BLOCK-1) & ~(uintptr_t)(configHEAP_BUDDY_MAX_BLOCK-1));
+      uint8_t *limit = (uint8_t *)&__HeapBuddyLimit;
+      uint32_t tops = (limit > base) ? (uint32_t)((limit-base) / configHEAP_BUDDY_MAX_BLOCK) : 0;
+      size_t bitmapWords;
+      for(;; tops--) { // largest number of top-level blocks leaving room for the bitmaps
+          bitmapWords = ((size_t)tops * ((1u << HEAP_BUDDY_ORDERS) - 1) + 31) / 32;
+          if(tops == 0 || base + (size_t)tops*configHEAP_BUDDY_MAX_BLOCK + 2*bitmapWords*sizeof(uint32_t) <= limit) break;
+      }
+      if(tops == 0) return; // region too small to use
+      heapBuddy.base = base;
+      heapBuddy.limit = base + (size_t)tops*configHEAP_BUDDY_MAX_BLOCK;
+      heapBuddy.splitBits = (uint32_t *)heapBuddy.limit;
+      heapBuddy.freeBits = heapBuddy.splitBits + bitmapWords;
+      memset(heapBuddy.splitBits, 0, 2*bitmapWords*sizeof(uint32_t));
+      for(int order = 0, index = 0; order < HEAP_BUDDY_ORDERS; order++) {
+          heapBuddy.nodeIndex[order] = index;
+          index += tops << (HEAP_BUDDY_TOP - order);
+      }
+      for(uint8_t *b = heapBuddy.limit; b > base; ) { // lowest address at head of free list
+          b -= configHEAP_BUDDY_MAX_BLOCK;
+          heapBuddyPush(b, HEAP_BUDDY_TOP);
+      }
+      heapBuddy.freeBytes = heapBuddy.minFreeBytes = (size_t)tops*configHEAP_BUDDY_MAX_BLOCK;
+  }
+  static bool heapIsBuddyBlock(const void *pv) {
+      return (const uint8_t *)pv >= heapBuddy.base && (const uint8_t *)pv < heapBuddy.limit;
+  }
+  //! Order of an allocated buddy block: below its first split ancestor. Called with heap locked.
+  static int heapBuddyOrder(uint8_t *b) {
+      int order = 0;
+      while(order < HEAP_BUDDY_TOP && !heapBuddyBit(heapBuddy.splitBits, heapBuddyNode(b, order+1))) order++;
+      return order;
+  }
+  static void *heapBuddyAllocate(size_t xSize) {
+      uint8_t *b = NULL;
+      UBaseType_t usis = heapWrapLock();
+      if(!heapBuddy.initialized) heapBuddyInit();
+      int order = HEAP_BUDDY_ORDERS, o = HEAP_BUDDY_ORDERS; // too large: fails below
+      if(xSize <= configHEAP_BUDDY_MAX_BLOCK) { // first, so xSize-1 fits the 32-bit clz (and isn't 0 after truncation)
+          order = (xSize <= configHEAP_BUDDY_MIN_BLOCK) ? 0 : (int)(32 - __builtin_clz((unsigned)(xSize-1))) - HEAP_BUDDY_MIN_SHIFT;
+          for(o = order; o < HEAP_BUDDY_ORDERS && heapBuddy.freeList[o] == NULL; o++) {}
+      }
+      if(o < HEAP_BUDDY_ORDERS) {
+          b = (uint8_t *)heapBuddy.freeList[o];
+          heapBuddyRemove(b, o);
+          while(o > order) { // split, keeping lower half and freeing upper half
+              heapBuddySetBit(heapBuddy.splitBits, heapBuddyNode(b, o), true);
+              o--;
+              heapBuddyPush(b + ((size_t)configHEAP_BUDDY_MIN_BLOCK << o), o);
+          }
+          heapBuddy.freeBytes -= (size_t)configHEAP_BUDDY_MIN_BLOCK << order;
+          if(heapBuddy.freeBytes < heapBuddy.minFreeBytes) heapBuddy.minFreeBytes = heapBuddy.freeBytes;
+          heapBuddy.allocations++;
+      } else {
+          heapBuddy.failures++;
+      }
+      heapWrapUnlock(usis);
+      return b;
+  }
+  static void heapBuddyRelease(void *pv) {
+      uint8_t *b = pv;
+      UBaseType_t usis = heapWrapLock();
+      int order = heapBuddyOrder(b);
+      configASSERT( ((b - heapBuddy.base) & (((size_t)configHEAP_BUDDY_MIN_BLOCK << order)-1)) == 0 ); // not a block start
+      configASSERT( !heapBuddyBit(heapBuddy.freeBits, heapBuddyNode(b, order)) ); // already free
+      heapBuddy.freeBytes += (size_t)configHEAP_BUDDY_MIN_BLOCK << order;
+      while(order < HEAP_BUDDY_TOP) { // coalesce with free buddy
+          uint8_t *buddy = heapBuddy.base + ((size_t)(b - heapBuddy.base) ^ ((size_t)configHEAP_BUDDY_MIN_BLOCK << order));
+          if(!heapBuddyBit(heapBuddy.freeBits, heapBuddyNode(buddy, order))) break;
+          heapBuddyRemove(buddy, order);
+          if(buddy < b) b = buddy;
+          order++;
+          heapBuddySetBit(heapBuddy.splitBits, heapBuddyNode(b, order), false);
+      }
+      heapBuddyPush(b, order);
+      heapWrapUnlock(usis);
+  }
+  static size_t heapBuddyBlockSize(void *pv) {
+      UBaseType_t usis = heapWrapLock();
+      int order = heapBuddyOrder(pv);
+      heapWrapUnlock(usis);
+      return (size_t)configHEAP_BUDDY_MIN_BLOCK << order;
+  }
+
+  //! Allocate a power-of-two block (xSize rounded up, at least configHEAP_BUDDY_MIN_BLOCK), aligned
+  //! to its size, from the buddy region. NULL if larger than configHEAP_BUDDY_MAX_BLOCK or no room.
+  void *pvPortMallocBuddy( size_t xSize ) PRIVILEGED_FUNCTION {
+      HEAP_LATENCY_BEGIN();
+      void *p = heapBuddyAllocate(xSize);
+      HEAP_LATENCY_END(eHeapOpPvPortMallocBuddy);
+      return p;
+  }
+  void vPortGetBuddyStats( HeapBuddyStats_t *pxStats ) {
+      UBaseType_t usis = heapWrapLock();
+      if(!heapBuddy.initialized) heapBuddyInit();
+      pxStats->xFreeBytes = heapBuddy.freeBytes;
+      pxStats->xMinimumEverFreeBytes = heapBuddy.minFreeBytes;
+      pxStats->ulAllocations = heapBuddy.allocations;
+      pxStats->ulFailures = heapBuddy.failures;
+      for(int order = 0; order < HEAP_BUDDY_ORDERS; order++) {
+          uint16_t n = 0;
+          for(heapBuddyFree_t *f = heapBuddy.freeList[order]; f; f = f->next) n++;
+          pxStats->ausFreeBlocks[order] = n;
+      }
+      heapWrapUnlock(usis);
+  }
+#endif
+
+#if defined(configHEAP_MOVABLE_BYTES) && configHEAP_MOVABLE_BYTES // DRN relocatable blocks, compacted when idle
+  // Movable blocks live in their own area (configHEAP_MOVABLE_BYTES of static storage), laid out
+  // contiguously in address order, each with a header naming its owning handle. Applications hold
+  // handles, and use a block's address only while it is locked. vPortHeapCompactFromIdleHook
+  // slides unlocked blocks down over free space in bounded steps, so free space collects at the
+  // top of the area. Lock and unlock need no heap lock: compaction runs with the scheduler
+  // suspended, so it can't observe a task midway through locking.
+  #ifndef configHEAP_MOVABLE_HANDLES
+    #define configHEAP_MOVABLE_HANDLES 32
+  #endif
+  #ifndef configHEAP_MOVABLE_COMPACT_BYTES
+    #define configHEAP_MOVABLE_COMPACT_BYTES 1024 // moved per compaction step (at least one block)
+  #endif
+  typedef struct heapMovableBlock {
+      size_t size;               // including header; multiple of 8
+      struct HeapMovable *owner; // NULL: free
+  } heapMovableBlock_t;
+  struct HeapMovable {
+      heapMovableBlock_t *block; // NULL: handle unused
+      uint32_t locks;            // while nonzero, block is pinned
+  };
+  static uint64_t heapMovableArea[(configHEAP_MOVABLE_BYTES+7)/8];
+  static struct HeapMovable heapMovableHandles[configHEAP_MOVABLE_HANDLES];
+  static uint8_t *heapMovableTop = (uint8_t *)heapMovableArea; // end of last block
+  static uint8_t *heapMovableCursor = (uint8_t *)heapMovableArea; // compaction resumes here
+  #define HEAP_MOVABLE_END      ((uint8_t *)heapMovableArea + sizeof(heapMovableArea))
+  #define heapMovableNext(b)    ((heapMovableBlock_t *)((uint8_t *)(b) + (b)->size))
+
+  //! Slide unlocked blocks down over free space, moving about maxBytes. Called with heap locked.
+  //! Returns true when a pass over the whole area has completed.
+  static bool heapMovableCompact(size_t maxBytes) {
+      size_t moved = 0;
+      heapMovableBlock_t *b = (heapMovableBlock_t *)heapMovableCursor;
+      while((uint8_t *)b < heapMovableTop) {
+          if(b->owner) { b = heapMovableNext(b); continue; }
+          heapMovableBlock_t *n = heapMovableNext(b);
+          while((uint8_t *)n < heapMovableTop && !n->owner) { // merge following free blocks
+              b->size += n->size;
+              n = heapMovableNext(b);
+          }
+          if((uint8_t *)n >= heapMovableTop) { heapMovableTop = (uint8_t *)b; break; } // free space at top
+          if(n->owner->locks) { b = heapMovableNext(n); continue; } // pinned: hole stays for now
+          if(moved && moved + n->size > maxBytes) { heapMovableCursor = (uint8_t *)b; return false; }
+          size_t freeSize = b->size;
+          struct HeapMovable *h = n->owner;
+          moved += n->size;
+          memmove(b, n, n->size);
+          h->block = b;
+          b = heapMovableNext(b);
+          b->size = freeSize;
+          b->owner = NULL;
+      }
+      heapMovableCursor = (uint8_t *)heapMovableArea; // next pass starts over
+      return true;
+  }
+
+  //! Allocate a movable block; NULL if no handle or space is available. The block's address may
+  //! change whenever it isn't locked: get it with pvPortLockMovable.
+  HeapHandle_t xPortMallocMovable( size_t xSize ) {
+      if(xSize > configHEAP_MOVABLE_BYTES) return NULL;
+      size_t need = sizeof(heapMovableBlock_t) + ((xSize + 7) & ~(size_t)7);
+      if(xSize == 0) need += 8;
+      struct HeapMovable *h = NULL;
+      heapMovableBlock_t *b = NULL;
+      UBaseType_t usis = heapWrapLock();
+      for(int i = 0; i < configHEAP_MOVABLE_HANDLES && !h; i++) {
+          if(heapMovableHandles[i].block == NULL) h = &heapMovableHandles[i];
+      }
+      for(int attempt = 0; h && !b && attempt < 2; attempt++) {
+          for(heapMovableBlock_t *f = (heapMovableBlock_t *)heapMovableArea; (uint8_t *)f < heapMovableTop; f = heapMovableNext(f)) {
+              if(f->owner) continue;
+              while((uint8_t *)heapMovableNext(f) < heapMovableTop && !heapMovableNext(f)->owner) f->size += heapMovableNext(f)->size;
+              if(heapMovableCursor > (uint8_t *)f && heapMovableCursor < (uint8_t *)heapMovableNext(f)) heapMovableCursor = (uint8_t *)f;
+              if(f->size < need) continue;
+              if(f->size - need >= sizeof(heapMovableBlock_t) + 8) { // split off unused tail
+                  heapMovableBlock_t *tail = (heapMovableBlock_t *)((uint8_t *)f + need);
+                  tail->size = f->size - need;
+                  tail->owner = NULL;
+                  f->size = need;
+              }
+              b = f;
+              break;
+          }
+          if(!b && (size_t)(HEAP_MOVABLE_END - heapMovableTop) >= need) {
+              b = (heapMovableBlock_t *)heapMovableTop;
+              b->size = need;
+              heapMovableTop += need;
+          }
+          if(!b) while(!heapMovableCompact(SIZE_MAX)) {} // fragmented: compact fully, then retry
+      }
+      if(b) {
+          b->owner = h;
+          h->block = b;
+          h->locks = 0;
+      }
+      heapWrapUnlock(usis);
+      return b ? h : NULL;
+  }
+  void vPortFreeMovable( HeapHandle_t xHandle ) {
+      if(xHandle == NULL) return;
+      UBaseType_t usis = heapWrapLock();
+      configASSERT( xHandle->block && xHandle->locks == 0 );
+      heapMovableBlock_t *b = xHandle->block;
+      b->owner = NULL;
+      xHandle->block = NULL;
+      if((uint8_t *)heapMovableNext(b) >= heapMovableTop) heapMovableTop = (uint8_t *)b;
+      if((uint8_t *)b < heapMovableCursor) heapMovableCursor = (uint8_t *)b;
+      heapWrapUnlock(usis);
+  }
+  //! Pin a movable block and return its address, valid until the matching vPortUnlockMovable.
+  //! Locks nest. Don't call from an ISR.
+  void *pvPortLockMovable( HeapHandle_t xHandle ) {
+      (void)__atomic_fetch_add(&xHandle->locks, 1, __ATOMIC_ACQUIRE);
+      return xHandle->block + 1;
+  }
+  void vPortUnlockMovable( HeapHandle_t xHandle ) {
+      configASSERT( xHandle->locks );
+      (void)__atomic_fetch_sub(&xHandle->locks, 1, __ATOMIC_RELEASE);
+  }
+  size_t xPortGetMovableSize( HeapHandle_t xHandle ) {
+      return xHandle->block->size - sizeof(heapMovableBlock_t); // may exceed size requested
+  }
+  //! Call from vApplicationIdleHook: moves about configHEAP_MOVABLE_COMPACT_BYTES per call.
+  void vPortHeapCompactFromIdleHook( void ) {
+      UBaseType_t usis = heapWrapLock();
+      (void)heapMovableCompact(configHEAP_MOVABLE_COMPACT_BYTES);
+      heapWrapUnlock(usis);
+  }
+  //! Free bytes in the movable area (including headers), and optionally the largest contiguous free space.
+  size_t xPortGetMovableFreeSize( size_t *pxLargestFree ) {
+      size_t freeBytes = 0, largest = 0, run = 0;
+      UBaseType_t usis = heapWrapLock();
+      for(heapMovableBlock_t *b = (heapMovableBlock_t *)heapMovableArea; (uint8_t *)b < heapMovableTop; b = heapMovableNext(b)) {
+          if(b->owner) { run = 0; continue; }
+          freeBytes += b->size;
+          run += b->size;
+          if(run > largest) largest = run;
+      }
+      size_t top = (size_t)(HEAP_MOVABLE_END - heapMovableTop);
+      heapWrapUnlock(usis);
+      if(run + top > largest) largest = run + top;
+      if(pxLargestFree) *pxLargestFree = largest;
+      return freeBytes + top;
+  }
+#endif
+
+#if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE // DRN caches of freed kernel objects
+  #if defined(HEAP_BLOCK_HEADER) || (defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS)
+    #error "configHEAP_OBJECT_CACHE can't be combined with task accounting, redzone or leak detector (cached blocks would stay charged to the task that first allocated them)"
+  #endif
+  #ifndef configHEAP_OBJECT_CACHE_EXTRA_SIZES
+    #define configHEAP_OBJECT_CACHE_EXTRA_SIZES // application's own sizes, each preceded by a comma
+  #endif
+  #ifndef configHEAP_OBJECT_CACHE_MAX_FREE
+    #define configHEAP_OBJECT_CACHE_MAX_FREE 16 // most freed blocks each cache keeps
+  #endif
+  #ifndef configHEAP_OBJECT_CACHE_TRIM_TICKS
+    #define configHEAP_OBJECT_CACHE_TRIM_TICKS (10*configTICK_RATE_HZ) // period of usage statistics
+  #endif
+  #ifndef configHEAP_OBJECT_CACHE_TRACKED
+    #define configHEAP_OBJECT_CACHE_TRACKED 64 // power of two; up to 3/4 of it cache blocks outstanding at once
+  #endif
+  #if (configHEAP_OBJECT_CACHE_TRACKED & (configHEAP_OBJECT_CACHE_TRACKED-1)) != 0
+    #error "configHEAP_OBJECT_CACHE_TRACKED must be a power of two"
+  #endif
+  // The kernel allocates each queue, semaphore, timer, event group and TCB with one pvPortMalloc of a
+  // fixed size (plus storage for queues, and the stack for tasks). vPortFree keeps freed blocks of
+  // these sizes on a free list for the next create, instead of returning them to newlib.
+  // Only blocks pvPortMalloc handed out for a cache's size are taken back: they are tracked in a small
+  // hash table while outstanding, so an application block that happens to be the same size is freed
+  // normally. When the table is full, blocks are handed out untracked and freed normally.
+  // pvPortRealloc stops tracking a block, as do the free and realloc wrappers (if linked). Without the
+  // wrappers, a tracked block released with free() keeps its entry until its address is handed out again.
+  // A cache grows as objects are deleted. Every configHEAP_OBJECT_CACHE_TRIM_TICKS, blocks that
+  // stayed cached during the whole period (fewest cached) are surplus and go back to newlib.
+  static const size_t heapObjectCacheSizes[] = {
+      sizeof(StaticQueue_t), // also semaphores and mutexes (queues without storage)
+      sizeof(StaticTimer_t),
+      sizeof(StaticEventGroup_t),
+      sizeof(StaticTask_t)
+      configHEAP_OBJECT_CACHE_EXTRA_SIZES
+  };
+  #define HEAP_OBJECT_CACHES (sizeof(heapObjectCacheSizes)/sizeof(heapObjectCacheSizes[0]))
+  typedef struct heapCachedBlock { struct heapCachedBlock *next; } heapCachedBlock_t;
+  typedef struct {
+      heapCachedBlock_t *freeList;
+      uint16_t cached;              // blocks on freeList
+      uint16_t lowWater;            // fewest cached since last trim
+      uint16_t reserved;            // prefilled: never trimmed below this
+      uint32_t hits, misses, trimmed;
+  } heapObjectCache_t;
+  static heapObjectCache_t heapObjectCaches[HEAP_OBJECT_CACHES];
+  static size_t heapObjectCacheBytes; // held on free lists
+  // Outstanding cache blocks: open addressing, linear probing; cache index+1 in heapObjectTrackedCache.
+  static void *heapObjectTracked[configHEAP_OBJECT_CACHE_TRACKED];
+  static uint8_t heapObjectTrackedCache[configHEAP_OBJECT_CACHE_TRACKED];
+  static uint32_t heapObjectTrackedCount;
+
+  static uint32_t heapObjectTrackedSlot(const void *p) {
+      return ((uint32_t)((uintptr_t)p >> 3) * 2654435761u) & (configHEAP_OBJECT_CACHE_TRACKED-1);
+  }
+  // Called with wrapper lock held. false: table full, block not tracked.
+  static bool heapObjectTrack(void *p, size_t cache) {
+      uint32_t i = heapObjectTrackedSlot(p);
+      while(heapObjectTracked[i] && heapObjectTracked[i] != p) i = (i+1) & (configHEAP_OBJECT_CACHE_TRACKED-1);
+      if(heapObjectTracked[i] == NULL) { // else stale entry (block released with free): p was just handed out
+          if(heapObjectTrackedCount >= configHEAP_OBJECT_CACHE_TRACKED*3/4) return false;
+          heapObjectTrackedCount++;
+      }
+      heapObjectTracked[i] = p;
+      heapObjectTrackedCache[i] = (uint8_t)(cache+1);
+      return true;
+  }
+  // Called with wrapper lock held. Stop tracking p; returns its cache index+1, or 0 if not tracked.
+  static int heapObjectUntrack(const void *p) {
+      if(p == NULL) return 0;
+      uint32_t i = heapObjectTrackedSlot(p);
+      while(heapObjectTracked[i] != p) {
+          if(heapObjectTracked[i] == NULL) return 0;
+          i = (i+1) & (configHEAP_OBJECT_CACHE_TRACKED-1);
+      }
+      int cache = heapObjectTrackedCache[i];
+      heapObjectTrackedCount--;
+      // Backward-shift deletion: move later entries of the probe run into the hole.
+      for(uint32_t j = (i+1) & (configHEAP_OBJECT_CACHE_TRACKED-1); heapObjectTracked[j]; j = (j+1) & (configHEAP_OBJECT_CACHE_TRACKED-1)) {
+          uint32_t home = heapObjectTrackedSlot(heapObjectTracked[j]);
+          if(((j - home) & (configHEAP_OBJECT_CACHE_TRACKED-1)) >= ((j - i) & (configHEAP_OBJECT_CACHE_TRACKED-1))) {
+              heapObjectTracked[i] = heapObjectTracked[j];
+              heapObjectTrackedCache[i] = heapObjectTrackedCache[j];
+              i = j;
+          }
+      }
+      heapObjectTracked[i] = NULL;
+      return cache;
+  }
+  static int heapObjectCacheOfSize(size_t size) {
+      for(size_t i=0; i<HEAP_OBJECT_CACHES; i++) {
+          if(heapObjectCacheSizes[i] == size) return (int)i;
+      }
+      return -1;
+  }
+  //! Return up to n of cache's blocks to newlib.
+  static void heapObjectCacheRelease(size_t cache, uint32_t n) {
+      heapObjectCache_t *c = &heapObjectCaches[cache];
+      UBaseType_t usis = heapWrapLock();
+      heapCachedBlock_t *list = NULL;
+      for(; n && c->cached; n--) {
+          heapCachedBlock_t *b = c->freeList;
+          c->freeList = b->next;
+          b->next = list;
+          list = b;
+          c->cached--;
+          c->trimmed++;
+          heapObjectCacheBytes -= heapObjectCacheSizes[cache];
+      }
+      c->lowWater = c->cached;
+      heapWrapUnlock(usis);
+      while(list) { // outside lock
+          heapCachedBlock_t *b = list;
+          list = b->next;
+          free(b);
+      }
+  }
+  //! Return every cached block to newlib (reserved blocks too; they are kept again as they're freed).
+  void vPortObjectCacheFlush( void ) {
+      for(size_t i=0; i<HEAP_OBJECT_CACHES; i++) heapObjectCacheRelease(i, UINT32_MAX);
+  }
+  static void *heapObjectCacheAllocate(size_t xSize) {
+      int cache = heapObjectCacheOfSize(xSize);
+      if(cache < 0) return malloc(xSize);
+      heapObjectCache_t *c = &heapObjectCaches[cache];
+      UBaseType_t usis = heapWrapLock();
+      heapCachedBlock_t *b = c->freeList;
+      if(b && heapObjectTrack(b, (size_t)cache)) {
+          c->freeList = b->next;
+          if(--c->cached < c->lowWater) c->lowWater = c->cached;
+          c->hits++;
+          heapObjectCacheBytes -= xSize;
+      } else { // empty, or tracking table full (then the block from newlib isn't tracked either)
+          b = NULL;
+          c->misses++;
+      }
+      heapWrapUnlock(usis);
+      if(b) return b;
+      void *p = malloc(xSize);
+      if(p == NULL) { // heap exhausted: empty every cache and try again
+          vPortObjectCacheFlush();
+          p = malloc(xSize);
+      }
+      if(p) {
+          usis = heapWrapLock();
+          (void)heapObjectTrack(p, (size_t)cache); // if table full, p is freed normally
+          heapWrapUnlock(usis);
+      }
+      return p;
+  }
+  //! Keep a freed block if pvPortMalloc handed it out for one of the caches; false: free it.
+  static bool heapObjectCachePut(void *pv) {
+      if(pv == NULL) return false;
+      bool kept = false;
+      UBaseType_t usis = heapWrapLock();
+      int cache = heapObjectUntrack(pv);
+      if(cache) {
+          heapObjectCache_t *c = &heapObjectCaches[cache-1];
+          if(c->cached < configHEAP_OBJECT_CACHE_MAX_FREE || c->cached < c->reserved) {
+              heapCachedBlock_t *b = (heapCachedBlock_t *)pv;
+              b->next = c->freeList;
+              c->freeList = b;
+              c->cached++;
+              heapObjectCacheBytes += heapObjectCacheSizes[cache-1];
+              kept = true;
+          }
+      }
+      heapWrapUnlock(usis);
+      return kept;
+  }
+  //! Call from vApplicationIdleHook. Once per configHEAP_OBJECT_CACHE_TRIM_TICKS, return blocks
+  //! that weren't needed during the period to newlib, so caches follow the application's churn.
+  void vPortObjectCacheTrimFromIdleHook( void ) {
+      static TickType_t lastTrimTick;
+      TickType_t now = xTaskGetTickCount();
+      if((TickType_t)(now-lastTrimTick) < (TickType_t)(configHEAP_OBJECT_CACHE_TRIM_TICKS)) return;
+      lastTrimTick = now;
+      for(size_t i=0; i<HEAP_OBJECT_CACHES; i++) {
+          heapObjectCache_t *c = &heapObjectCaches[i];
+          uint32_t surplus = (c->lowWater > c->reserved) ? (uint32_t)(c->lowWater - c->reserved) : 0;
+          heapObjectCacheRelease(i, surplus);
+      }
+  }
+  //! Preallocate uxCount blocks for objects of xSize bytes (for example sizeof(StaticQueue_t)), kept
+  //! cached even when unused. Call at boot, before the heap fragments. pdFAIL if xSize has no cache
+  //! or the heap is exhausted.
+  BaseType_t xPortObjectCachePrefill( size_t xSize, UBaseType_t uxCount ) {
+      int cache = heapObjectCacheOfSize(xSize);
+      if(cache < 0) return pdFAIL;
+      heapObjectCache_t *c = &heapObjectCaches[cache];
+      UBaseType_t usis = heapWrapLock();
+      c->reserved = (uint16_t)(c->reserved + uxCount);
+      heapWrapUnlock(usis);
+      for(UBaseType_t n=0; n<uxCount; n++) {
+          void *p = malloc(xSize);
+          if(p == NULL) return pdFAIL;
+          usis = heapWrapLock();
+          heapCachedBlock_t *b = (heapCachedBlock_t *)p;
+          b->next = c->freeList;
+          c->freeList = b;
+          c->cached++;
+          heapObjectCacheBytes += xSize;
+          heapWrapUnlock(usis);
+      }
+      return pdPASS;
+  }
+  //! Fill pxStats with up to uxMaxCaches caches' statistics; returns the number of caches.
+  UBaseType_t uxPortGetObjectCacheStats( HeapObjectCacheStats_t *pxStats, UBaseType_t uxMaxCaches ) {
+      UBaseType_t usis = heapWrapLock();
+      for(UBaseType_t i=0; i<uxMaxCaches && i<HEAP_OBJECT_CACHES; i++) {
+          pxStats[i].xObjectSize = heapObjectCacheSizes[i];
+          pxStats[i].uxCached = heapObjectCaches[i].cached;
+          pxStats[i].xCachedBytes = heapObjectCaches[i].cached * heapObjectCacheSizes[i];
+          pxStats[i].ulHits = heapObjectCaches[i].hits;
+          pxStats[i].ulMisses = heapObjectCaches[i].misses;
+          pxStats[i].ulTrimmed = heapObjectCaches[i].trimmed;
+      }
+      heapWrapUnlock(usis);
+      return HEAP_OBJECT_CACHES;
+  }
+#endif
+
+// ================================================================================================
+// Implement FreeRTOS's memory API using newlib-provided malloc family.
+// ================================================================================================
+
+void *pvPortMalloc( size_t xSize ) PRIVILEGED_FUNCTION {
+    HEAP_LATENCY_ENTRY_BEGIN();
+    HEAP_NOTE_CALLER_BEGIN();
+    #if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE
+      void *p = heapObjectCacheAllocate(xSize);
+    #else
+      void *p = malloc(xSize);
+    #endif
+    HEAP_NOTE_CALLER_END();
+    HEAP_LATENCY_ENTRY_END(eHeapOpPvPortMalloc);
+    return p;
+}
+void vPortFree( void *pv ) PRIVILEGED_FUNCTION {
+    HEAP_LATENCY_ENTRY_BEGIN();
+    #if defined(HEAP_REGIONS)
+      heapRegion_t *r = heapRegionOf(pv);
+      if(r) heapRegionFree(r, pv); else
+    #endif
+    #if defined(configHEAP_BUDDY) && configHEAP_BUDDY
+      if(heapIsBuddyBlock(pv)) heapBuddyRelease(pv); else
+    #endif
+    #if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME
+      if(heapIsBootBlock(pv)) {} else // permanent (also without malloc wrappers)
+    #endif
+    #if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE
+      if(heapObjectCachePut(pv)) {} else
+    #endif
+    free(pv);
+    HEAP_LATENCY_ENTRY_END(eHeapOpVPortFree);
+}
+void *pvPortCalloc( size_t xNum, size_t xSize ) PRIVILEGED_FUNCTION {
+    HEAP_NOTE_CALLER_BEGIN();
+    void *p = calloc(xNum, xSize);
+    HEAP_NOTE_CALLER_END();
+    return p;
+}
+
+#if defined(_NANO_MALLOC) && !defined(HEAP_BLOCK_HEADER) && \
+    !(defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS)
+  // newlib-nano's realloc always copies to a new block when growing. If the block is the last
+  // chunk in the heap, grow it in place by extending the heap with sbrk instead.
+  // (Full newlib's realloc already grows in place into a following free chunk or the top chunk.)
+  static bool heapNanoGrowAtTop(void *pv, size_t xSize) {
+    typedef struct { long size; } nanoChunk_t; // newlib-nano's chunk header (precedes application's block)
+    bool grown = false;
+    #if defined(HEAP_BOOT_BLOCKS)
+      if(heapIsBootBlock(pv)) return false; // not a newlib chunk
+    #endif
+    __malloc_lock(_impure_ptr);
+    nanoChunk_t *c = (nanoChunk_t *)((char *)pv - sizeof(long));
+    if(c->size < 0) c = (nanoChunk_t *)((char *)c + c->size); // alignment padding: negative offset to chunk
+    char *chunkEnd = (char *)c + c->size;
+    char *needEnd = (char *)(((uintptr_t)pv + xSize + sizeof(void *)-1) & ~(uintptr_t)(sizeof(void *)-1));
+    if(chunkEnd == currentHeapEnd && needEnd > chunkEnd &&
+       (size_t)(needEnd-chunkEnd) <= heapBytesAvailableFromSbrk()) {
+        int incr = (int)(needEnd-chunkEnd);
+        if(_sbrk_r(_impure_ptr, incr) == chunkEnd) {
+            c->size += incr;
+            HeapBytesInUse += incr; // maintained by malloc wrappers (if used)
+            grown = true;
+        }
+    }
+    __malloc_unlock(_impure_ptr);
+    return grown;
+  }
+#endif
+//! Resize a block, in place when possible (avoids copying and holding both blocks).
+void *pvPortRealloc( void *pv, size_t xSize ) PRIVILEGED_FUNCTION {
+    #if defined(HEAP_REGIONS)
+      heapRegion_t *r = heapRegionOf(pv);
+      if(r) { // stays in its region
+          size_t oldSize = heapRegionBlock(pv)->size - HEAP_REGION_HEADER;
+          if(xSize <= oldSize) return pv;
+          void *p = heapRegionAllocate(r, 0, xSize);
+          if(p) { memcpy(p, pv, oldSize); heapRegionFree(r, pv); }
+          return p;
+      }
+    #endif
+    #if defined(configHEAP_BUDDY) && configHEAP_BUDDY
+      if(heapIsBuddyBlock(pv)) { // stays in buddy region
+          size_t oldSize = heapBuddyBlockSize(pv);
+          if(xSize <= oldSize) return pv;
+          void *p = heapBuddyAllocate(xSize);
+          if(p) { memcpy(p, pv, oldSize); heapBuddyRelease(pv); }
+          return p;
+      }
+    #endif
+    #if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME
+      if(pv && heapIsBootBlock(pv)) { // permanent (also without malloc wrappers): stays in place, grow by copying
+          size_t oldSize = heapBootBlockSize(pv);
+          if(xSize <= oldSize) return pv;
+          void *p = pvPortMalloc(xSize);
+          if(p) memcpy(p, pv, oldSize);
+          return p;
+      }
+    #endif
+    #if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE
+      if(pv) { // resized (or freed): no longer the size of its cache
+          UBaseType_t usis = heapWrapLock();
+          (void)heapObjectUntrack(pv);
+          heapWrapUnlock(usis);
+      }
+    #endif
+    #if defined(_NANO_MALLOC) && !defined(HEAP_BLOCK_HEADER) && \
+        !(defined(configHEAP_LEAK_DETECTOR_BLOCKS) && configHEAP_LEAK_DETECTOR_BLOCKS)
+      if(pv && heapNanoGrowAtTop(pv, xSize)) return pv;
+    #endif
+    HEAP_NOTE_CALLER_BEGIN();
+    void *p = realloc(pv, xSize);
+    HEAP_NOTE_CALLER_END();
+    return p;
+}
+//! Bytes the application may actually use in a block (at least the size requested), so callers
+//! can grow a buffer up to this size without reallocating.
+size_t xPortGetUsableSize( void *pv ) PRIVILEGED_FUNCTION {
+    #if defined(HEAP_REGIONS)
+      if(pv && heapRegionOf(pv)) return heapRegionBlock(pv)->size - HEAP_REGION_HEADER;
+    #endif
+    #if defined(configHEAP_BUDDY) && configHEAP_BUDDY
+      if(heapIsBuddyBlock(pv)) return heapBuddyBlockSize(pv);
+    #endif
+    #if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME
+      if(pv && heapIsBootBlock(pv)) return heapBootBlockSize(pv);
+    #endif
+    return pv ? malloc_usable_size(pv) : 0;
+}
+
+//! Allocate a block starting on an xAlignment boundary (a power of two), padded to a multiple of
+//! xAlignment. With cache-line alignment the block shares no cache line with other data, so
+//! cache clean/invalidate for DMA cannot corrupt neighbours.
+void *pvPortMallocAligned( size_t xAlignment, size_t xSize ) PRIVILEGED_FUNCTION {
+    configASSERT( xAlignment && (xAlignment & (xAlignment-1)) == 0 );
+    if(xSize > SIZE_MAX-xAlignment) return NULL;
+    HEAP_NOTE_CALLER_BEGIN();
+    void *p = memalign(xAlignment, (xSize + xAlignment-1) & ~(xAlignment-1));
+    HEAP_NOTE_CALLER_END();
+    return p;
+}
+//! Allocate a DMA buffer: from the non-cacheable DMA region if configured (no cache maintenance
+//! needed), else cache-line aligned and sized from the heap.
+void *pvPortMallocDma( size_t xSize ) PRIVILEGED_FUNCTION {
+    #if defined(configHEAP_REGION_DMA) && configHEAP_REGION_DMA
+      void *p = pvPortMallocRegion(eHeapRegionDma, 0, xSize);
+      if(p) return p;
+    #endif
+    return pvPortMallocAligned(configHEAP_CACHE_LINE_SIZE, xSize);
+}
+uint32_t HeapPlacementFallbacks; // placed allocations served by newlib's heap because region was full
+//! Allocate in the memory best suited to the data, else from newlib's heap. Fast and bulk
+//! placement use their regions when configured; without the region they are plain pvPortMalloc.
+void *pvPortMallocPlaced( size_t xSize, eHeapPlacement ePlacement ) PRIVILEGED_FUNCTION {
+    void *p = NULL;
+    switch(ePlacement) {
+      #if defined(configHEAP_REGION_FAST) && configHEAP_REGION_FAST
+        case eHeapPlacementFast: p = pvPortMallocRegion(eHeapRegionFast, 0, xSize); break;
+      #endif
+      #if defined(configHEAP_REGION_BULK) && configHEAP_REGION_BULK
+        case eHeapPlacementBulk: p = pvPortMallocRegion(eHeapRegionBulk, 0, xSize); break;
+      #endif
+      case eHeapPlacementDma: return pvPortMallocDma(xSize); // does its own fallback
+      default: return pvPortMalloc(xSize);
+    }
+    if(p) return p;
+    HeapPlacementFallbacks++;
+    return pvPortMalloc(xSize);
+}
+
+//! Allocate according to how long the block will live. Permanent blocks (never freed) come from the
+//! top of the heap when configHEAP_LIFETIME is set; transient blocks come from the transient region
+//! when configured. Otherwise, and for long-lived blocks, allocate from newlib's heap.
+void *pvPortMallocLifetime( size_t xSize, eHeapLifetime eLifetime ) PRIVILEGED_FUNCTION {
+    void *p = NULL;
+    switch(eLifetime) {
+      #if defined(configHEAP_LIFETIME) && configHEAP_LIFETIME
+        case eHeapLifetimePermanent: p = heapPermanentAllocate(0, xSize); break;
+      #endif
+      #if defined(configHEAP_REGION_TRANSIENT) && configHEAP_REGION_TRANSIENT
+        case eHeapLifetimeTransient: p = pvPortMallocRegion(eHeapRegionTransient, 0, xSize); break;
+      #endif
+      default: return pvPortMalloc(xSize);
+    }
+    if(p) return p;
+    HeapPlacementFallbacks++;
+    return pvPortMalloc(xSize);
+}
+
+#if defined(configHEAP_RESERVE_BYTES) && configHEAP_RESERVE_BYTES // DRN emergency reserve
+//! Allocate for a critical path (fault logging, shutdown): may use the emergency reserve.
+void *pvPortMallocCritical( size_t xSize ) PRIVILEGED_FUNCTION {
+    UBaseType_t usis = heapWrapLock(); // no other task (or ISR, if MALLOCS_INSIDE_ISRs) may allocate while the critical flag is set
+    heapCriticalAllocation = true;
+    HEAP_NOTE_CALLER_BEGIN();
+    void *p = malloc(xSize);
+    HEAP_NOTE_CALLER_END();
+    heapCriticalAllocation = false;
+    heapWrapUnlock(usis);
+    return p;
+}
+#endif
+
+#if defined(configHEAP_ARENA) && configHEAP_ARENA // DRN arena allocator
+// An arena hands out memory from chunks with a bump pointer, and releases everything at once.
+// Only growing the arena (pvPortMalloc of another chunk) takes the heap lock. Chunks are linked
+// in order of use; reset keeps them for reuse, so a reset arena reaches steady state without
+// heap calls. Arenas are not thread-safe: each belongs to one task (or is otherwise serialized).
+static uint8_t *heapArenaAlignUp(uint8_t *p, size_t xAlignment) {
+    return (uint8_t *)(((uintptr_t)p + xAlignment-1) & ~(uintptr_t)(xAlignment-1));
+}
+static void heapArenaUseChunk(HeapArena_t *pxArena, HeapArenaChunk_t *pxChunk) {
+    pxArena->pxCurrent = pxChunk;
+    pxArena->pucNext = pxChunk ? (uint8_t *)(pxChunk+1) : NULL;
+    pxArena->pucLimit = pxChunk ? pxChunk->pucLimit : NULL;
+}
+//! Initialize an arena. Its first chunk is pvBuffer (static or stack memory, never freed) if not NULL.
+//! When full, the arena grows by allocating chunks of xChunkSize bytes (or larger, for a larger
+//! request) with pvPortMalloc; xChunkSize 0 means never grow.
+void vPortArenaInit( HeapArena_t *pxArena, void *pvBuffer, size_t xBufferSize, size_t xChunkSize ) {
+    pxArena->pxFirst = NULL;
+    pxArena->pvStaticBuffer = NULL;
+    pxArena->xChunkSize = xChunkSize;
+    if(pvBuffer) {
+        HeapArenaChunk_t *c = (HeapArenaChunk_t *)heapArenaAlignUp((uint8_t *)pvBuffer, portBYTE_ALIGNMENT);
+        configASSERT( (uint8_t *)(c+1) <= (uint8_t *)pvBuffer + xBufferSize );
+        c->pxNext = NULL;
+        c->pucLimit = (uint8_t *)pvBuffer + xBufferSize;
+        pxArena->pxFirst = c;
+        pxArena->pvStaticBuffer = c;
+    }
+    heapArenaUseChunk(pxArena, pxArena->pxFirst);
+}
+//! Allocate from an arena, aligned to xAlignment (a power of two; 0 for portBYTE_ALIGNMENT).
+//! NULL if the arena is full and can't grow. Blocks are never freed individually.
+void *pvPortArenaAllocAligned( HeapArena_t *pxArena, size_t xAlignment, size_t xSize ) {
+    if(xAlignment < portBYTE_ALIGNMENT) xAlignment = portBYTE_ALIGNMENT;
+    configASSERT( (xAlignment & (xAlignment-1)) == 0 );
+    for(;;) {
+        uint8_t *p = heapArenaAlignUp(pxArena->pucNext, xAlignment);
+        if(pxArena->pucNext && p <= pxArena->pucLimit && xSize <= (size_t)(pxArena->pucLimit - p)) {
+            pxArena->pucNext = p + xSize;
+            return p;
+        }
+        // Current chunk is full: continue in the next chunk kept by reset if the block fits there,
+        // else in a new chunk inserted after the current one.
+        if(xSize > SIZE_MAX - xAlignment - sizeof(HeapArenaChunk_t)) return NULL;
+        size_t need = xSize + xAlignment; // worst-case alignment padding
+        HeapArenaChunk_t *next = pxArena->pxCurrent ? pxArena->pxCurrent->pxNext : pxArena->pxFirst;
+        if(next == NULL || (size_t)(next->pucLimit - (uint8_t *)(next+1)) < need) {
+            if(pxArena->xChunkSize == 0) return NULL;
+            size_t bytes = sizeof(HeapArenaChunk_t) + ((need > pxArena->xChunkSize) ? need : pxArena->xChunkSize);
+            HeapArenaChunk_t *c = pvPortMalloc(bytes);
+            if(c == NULL) return NULL;
+            c->pucLimit = (uint8_t *)c + bytes;
+            c->pxNext = next;
+            if(pxArena->pxCurrent) pxArena->pxCurrent->pxNext = c; else pxArena->pxFirst = c;
+            next = c;
+        }
+        heapArenaUseChunk(pxArena, next);
+    }
+}
+void *pvPortArenaAlloc( HeapArena_t *pxArena, size_t xSize ) {
+    return pvPortArenaAllocAligned(pxArena, 0, xSize);
+}
+//! Release every block in the arena, in O(1). Chunks are kept and reused.
+void vPortArenaReset( HeapArena_t *pxArena ) {
+    heapArenaUseChunk(pxArena, pxArena->pxFirst);
+}
+//! Release every block, and return the arena's chunks to the heap (all but a static first chunk).
+//! The arena remains usable, as if just initialized.
+void vPortArenaDestroy( HeapArena_t *pxArena ) {
+    HeapArenaChunk_t *c = pxArena->pxFirst;
+    while(c) {
+        HeapArenaChunk_t *next = c->pxNext;
+        if(c != pxArena->pvStaticBuffer) vPortFree(c);
+        c = next;
+    }
+    pxArena->pxFirst = pxArena->pvStaticBuffer;
+    if(pxArena->pxFirst) pxArena->pxFirst->pxNext = NULL;
+    heapArenaUseChunk(pxArena, pxArena->pxFirst);
+}
+#endif
+
+size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION {
+    struct mallinfo mi = mallinfo(); // available space now managed by newlib
+    #if defined(configHEAP_OBJECT_CACHE) && configHEAP_OBJECT_CACHE
+      mi.fordblks += heapObjectCacheBytes; // cached blocks are released when an allocation would fail
+    #endif
+    return mi.fordblks + heapBytesAvailableFromSbrk(); // plus space not yet handed to newlib by sbrk
+}
+
+// GetMinimumEverFree is not available in newlib's malloc implementation.
+// So, no implementation is provided: size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
+
+//! No implementation needed, but stub provided in case application already calls vPortInitialiseBlocks
+void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION {}
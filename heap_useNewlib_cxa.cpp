@@ -0,0 +1,296 @@
+/**
+ * \file heap_useNewlib_cxa.cpp
+ * \brief C++ runtime (ABI) support for FreeRTOS, for use with heap_useNewlib_NXP.c or heap_useNewlib_ST.c.
+ *
+ * \par Overview
+ * Exception allocation (configHEAP_EXCEPTION_POOL_BLOCKS): replaces libsupc++'s
+ * __cxa_allocate_exception family. Exception objects come from a static pool of fixed-size
+ * blocks, claimed and released with atomic operations (LDREX/STREX on Cortex-M3/4/7), so a
+ * throw neither takes __malloc_lock nor suspends the scheduler, and concurrent throws
+ * don't contend on a lock. Throw latency is bounded and independent of heap state.
+ * Exceptions too large for a block, or thrown while all blocks are in use, are allocated
+ * with pvPortMalloc (counted in HeapExceptionPoolMisses); if that fails, std::terminate.
+ *
+ * Function-local statics (configHEAP_CXA_GUARD): replaces libsupc++'s __cxa_guard_acquire,
+ * __cxa_guard_release and __cxa_guard_abort. Once a static is initialized, acquire is a single
+ * acquire load. A task that finds another task initializing the same static blocks on a task
+ * notification until initialization completes, so unrelated statics never serialize each other
+ * and no global critical section or mutex is held while a constructor runs. Waiting tasks are
+ * registered in a small table (configHEAP_CXA_GUARD_WAITERS); when it is full, waiters poll
+ * with vTaskDelay instead. Waits use a dedicated notification index (configHEAP_CXA_GUARD_NOTIFY_INDEX),
+ * so they never consume the application's notifications. Guard words are assumed little-endian (Cortex-M).
+ * Statics being initialized are recorded with their task (configHEAP_CXA_GUARD_INITIALIZERS), so a
+ * task that reaches a static it is itself initializing (recursive initialization) fails
+ * configASSERT and calls std::terminate, rather than waiting for itself forever.
+ *
+ * \author Dave Nadler
+ * \date 16-Oct-2026
+ *
+ * \copyright
+ * (c) Dave Nadler 2017-2026, All Rights Reserved.
+ * See heap_useNewlib_NXP.c for license terms.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // memset
+#include <exception> // terminate
+#include <cxxabi.h>
+#include <unwind.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_useNewlib.h"
+
+extern "C" {
+  void *pvPortMalloc( size_t xSize );
+  void vPortFree( void *pv );
+}
+
+#if defined(configHEAP_EXCEPTION_POOL_BLOCKS) && configHEAP_EXCEPTION_POOL_BLOCKS // DRN exception object pool
+  #ifndef configHEAP_EXCEPTION_POOL_OBJECT_SIZE
+    #define configHEAP_EXCEPTION_POOL_OBJECT_SIZE 64 // largest thrown object served from the pool
+  #endif
+  #if configHEAP_EXCEPTION_POOL_BLOCKS > 32
+    #error "configHEAP_EXCEPTION_POOL_BLOCKS must be 32 or less"
+  #endif
+
+uint32_t HeapExceptionPoolMisses; // exceptions allocated from the heap because the pool couldn't serve them
+
+namespace {
+  // Layout of libsupc++'s __cxa_refcounted_exception (unwind-cxx.h, not installed with the toolchain),
+  // which precedes each thrown object. Only its size is used here: the exception header size, which
+  // must match libsupc++'s.
+  struct CxaException {
+    std::type_info *exceptionType;
+    void (*exceptionDestructor)(void *);
+    std::terminate_handler unexpectedHandler;
+    std::terminate_handler terminateHandler;
+    CxaException *nextException;
+    int handlerCount;
+    #if defined(__ARM_EABI_UNWINDER__)
+      CxaException *nextPropagatingException;
+      int propagationCount;
+    #else
+      int handlerSwitchValue;
+      const unsigned char *actionRecord;
+      const unsigned char *languageSpecificData;
+      _Unwind_Ptr catchTemp;
+      void *adjustedPtr;
+    #endif
+    _Unwind_Exception unwindHeader;
+  };
+  struct CxaRefcountedException {
+    int referenceCount;
+    CxaException exc;
+  };
+  // The unwinder finds these fields by offset from the thrown object, so a mismatch with libsupc++ reads
+  // garbage. Sizes checked against GCC 12.2's libsupc++ (unwind-cxx.h, and unwind-arm-common.h for the
+  // 88-byte ARM _Unwind_Control_Block); recheck the layout above if a new toolchain trips these.
+  #if defined(__ARM_EABI_UNWINDER__)
+    static_assert(sizeof(CxaException) == 120 && sizeof(CxaRefcountedException) == 128,
+                  "libsupc++ ARM EABI exception header layout changed: update CxaException");
+  #elif defined(__x86_64__) // host builds
+    static_assert(sizeof(CxaException) == 112 && sizeof(CxaRefcountedException) == 128,
+                  "libsupc++ x86-64 exception header layout changed: update CxaException");
+  #endif
+  constexpr size_t ehHeaderSize = sizeof(CxaRefcountedException); // 128 for ARM EABI
+  constexpr size_t ehAlignment  = alignof(CxaRefcountedException);
+  constexpr size_t ehBlockSize  = (ehHeaderSize + configHEAP_EXCEPTION_POOL_OBJECT_SIZE + ehAlignment-1) & ~(ehAlignment-1);
+  constexpr uint32_t ehAllBlocks = (configHEAP_EXCEPTION_POOL_BLOCKS == 32) ? 0xFFFFFFFFu :
+                                   ((1u << configHEAP_EXCEPTION_POOL_BLOCKS) - 1);
+
+  alignas(ehAlignment) uint8_t ehPool[configHEAP_EXCEPTION_POOL_BLOCKS][ehBlockSize];
+  uint32_t ehPoolInUse; // bit n set: ehPool[n] allocated
+
+  void *ehAllocate(size_t size) {
+    if(size <= ehBlockSize) {
+      uint32_t inUse = __atomic_load_n(&ehPoolInUse, __ATOMIC_RELAXED);
+      uint32_t available;
+      while((available = ~inUse & ehAllBlocks) != 0) {
+        uint32_t bit = available & -available;
+        if(__atomic_compare_exchange_n(&ehPoolInUse, &inUse, inUse | bit, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+          return ehPool[__builtin_ctz(bit)];
+        }
+      }
+    }
+    (void)__atomic_fetch_add(&HeapExceptionPoolMisses, 1, __ATOMIC_RELAXED);
+    void *p = pvPortMalloc(size);
+    if(p == nullptr) std::terminate(); // as libsupc++ does when it can't allocate an exception
+    return p;
+  }
+  void ehFree(void *p) {
+    if((uint8_t *)p >= &ehPool[0][0] && (uint8_t *)p < &ehPool[configHEAP_EXCEPTION_POOL_BLOCKS][0]) {
+      uint32_t n = (uint32_t)(((uint8_t *)p - &ehPool[0][0]) / ehBlockSize);
+      (void)__atomic_fetch_and(&ehPoolInUse, ~(1u << n), __ATOMIC_RELEASE);
+    } else {
+      vPortFree(p);
+    }
+  }
+} // namespace
+
+namespace __cxxabiv1 {
+  extern "C" void *__cxa_allocate_exception(size_t thrown_size) noexcept {
+    void *p = ehAllocate(ehHeaderSize + thrown_size);
+    memset(p, 0, ehHeaderSize);
+    return (uint8_t *)p + ehHeaderSize;
+  }
+  extern "C" void __cxa_free_exception(void *vptr) noexcept {
+    ehFree((uint8_t *)vptr - ehHeaderSize);
+  }
+  // Dependent exceptions (std::rethrow_exception) have the same layout as __cxa_exception.
+  extern "C" __cxa_dependent_exception *__cxa_allocate_dependent_exception() noexcept {
+    void *p = ehAllocate(sizeof(CxaException));
+    memset(p, 0, sizeof(CxaException));
+    return (__cxa_dependent_exception *)p;
+  }
+  extern "C" void __cxa_free_dependent_exception(__cxa_dependent_exception *vptr) noexcept {
+    ehFree(vptr);
+  }
+} // namespace __cxxabiv1
+#endif
+
+#if defined(configHEAP_CXA_GUARD) && configHEAP_CXA_GUARD // DRN thread-safe initialization of function-local statics
+  #ifndef configHEAP_CXA_GUARD_WAITERS
+    #define configHEAP_CXA_GUARD_WAITERS 4 // tasks that can block on a guard at once
+  #endif
+  #ifndef configHEAP_CXA_GUARD_INITIALIZERS
+    #define configHEAP_CXA_GUARD_INITIALIZERS 8 // statics being initialized at once (nested, or by different tasks)
+  #endif
+  // Guard waits need a notification index of their own (FreeRTOS 10.4+): index 0 belongs to the
+  // application's ulTaskNotifyTake/xTaskNotifyWait, whose notifications a guard wait would consume.
+  #if !defined(configHEAP_CXA_GUARD_NOTIFY_INDEX) || !defined(configTASK_NOTIFICATION_ARRAY_ENTRIES) || \
+      (configTASK_NOTIFICATION_ARRAY_ENTRIES < 2)
+    #error "configHEAP_CXA_GUARD requires configHEAP_CXA_GUARD_NOTIFY_INDEX, a notification index reserved for guard waits (configTASK_NOTIFICATION_ARRAY_ENTRIES > 1)"
+  #elif (configHEAP_CXA_GUARD_NOTIFY_INDEX < 1) || (configHEAP_CXA_GUARD_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES)
+    #error "configHEAP_CXA_GUARD_NOTIFY_INDEX must be between 1 and configTASK_NOTIFICATION_ARRAY_ENTRIES-1"
+  #endif
+  #define heapGuardNotifyGive(task) xTaskNotifyGiveIndexed((task), configHEAP_CXA_GUARD_NOTIFY_INDEX)
+  #define heapGuardNotifyTake()     (void)ulTaskNotifyTakeIndexed(configHEAP_CXA_GUARD_NOTIFY_INDEX, pdTRUE, portMAX_DELAY)
+  #define heapGuardNotifyClear()    (void)ulTaskNotifyTakeIndexed(configHEAP_CXA_GUARD_NOTIFY_INDEX, pdTRUE, 0)
+
+namespace {
+  // State in the guard's first word. The compiler's inline check tests only the low byte
+  // (ARM EABI: bit 0), which is set exactly when initialization is complete.
+  constexpr uint32_t guardDone    = 1u << 0;
+  constexpr uint32_t guardBusy    = 1u << 8;  // a task is running the initializer
+  constexpr uint32_t guardWaiting = 1u << 16; // a task may be registered in guardWaiters
+  constexpr uint32_t guardOwned   = 1u << 24; // initializing task is registered in guardInitializers
+  struct GuardWaiter {
+    uint32_t *guard;     // nullptr: entry unused
+    TaskHandle_t task;
+  };
+  GuardWaiter guardWaiters[configHEAP_CXA_GUARD_WAITERS];
+  GuardWaiter guardInitializers[configHEAP_CXA_GUARD_INITIALIZERS]; // task running guard's initializer
+
+  //! Record current task as running guard's initializer. If the table is full it isn't recorded,
+  //! and recursive initialization of this static isn't detected.
+  void guardInitRegister(uint32_t *guard) {
+    if(xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED || xPortIsInsideInterrupt()) return;
+    taskENTER_CRITICAL();
+    for(GuardWaiter &e : guardInitializers) {
+      if(e.guard == nullptr) {
+        e.guard = guard;
+        e.task = xTaskGetCurrentTaskHandle();
+        (void)__atomic_fetch_or(guard, guardOwned, __ATOMIC_RELAXED); // inside critical: finisher can't scan yet
+        break;
+      }
+    }
+    taskEXIT_CRITICAL();
+  }
+  //! Is the current task running guard's initializer? Before the scheduler starts, a busy guard
+  //! can only be the current initialization's.
+  bool guardInitializedBySelf(uint32_t *guard) {
+    if(xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return true;
+    if(xPortIsInsideInterrupt()) return false;
+    bool self = false;
+    taskENTER_CRITICAL();
+    for(GuardWaiter &e : guardInitializers) {
+      if(e.guard == guard && e.task == xTaskGetCurrentTaskHandle()) self = true;
+    }
+    taskEXIT_CRITICAL();
+    return self;
+  }
+  //! Initializer of a static reached the same static. libsupc++ throws __gnu_cxx::recursive_init_error,
+  //! but that is defined alongside libsupc++'s guard functions, which would clash with these.
+  [[noreturn]] void guardRecursiveInit() {
+    configASSERT( false );
+    std::terminate();
+  }
+
+  //! Register current task as waiting for guard; returns the entry, or nullptr if the table is full.
+  GuardWaiter *guardWaitRegister(uint32_t *guard) {
+    GuardWaiter *w = nullptr;
+    taskENTER_CRITICAL();
+    for(GuardWaiter &e : guardWaiters) {
+      if(e.guard == nullptr) {
+        e.guard = guard;
+        e.task = xTaskGetCurrentTaskHandle();
+        w = &e;
+        break;
+      }
+    }
+    if(w) (void)__atomic_fetch_or(guard, guardWaiting, __ATOMIC_RELAXED); // inside critical: releaser can't scan yet
+    taskEXIT_CRITICAL();
+    return w;
+  }
+  void guardWaitUnregister(GuardWaiter *w) {
+    taskENTER_CRITICAL();
+    w->guard = nullptr;
+    taskEXIT_CRITICAL();
+    // A releaser may have notified after this task saw the guard finish and skipped its take:
+    // discard that notification, so it can't end this task's next guard wait early.
+    heapGuardNotifyClear();
+  }
+  //! Set guard to newState, forget its initializer, and wake any tasks waiting on it.
+  void guardFinish(uint32_t *guard, uint32_t newState) {
+    uint32_t old = __atomic_exchange_n(guard, newState, __ATOMIC_RELEASE);
+    if(old & (guardWaiting | guardOwned)) {
+      taskENTER_CRITICAL();
+      for(GuardWaiter &e : guardInitializers) {
+        if(e.guard == guard) e.guard = nullptr;
+      }
+      for(GuardWaiter &e : guardWaiters) {
+        if(e.guard == guard) heapGuardNotifyGive(e.task);
+      }
+      taskEXIT_CRITICAL();
+    }
+  }
+} // namespace
+
+namespace __cxxabiv1 {
+  //! Returns 1 if the caller must run the initializer (then call release or abort), 0 if already done.
+  extern "C" int __cxa_guard_acquire(__guard *g) {
+    uint32_t *guard = (uint32_t *)g;
+    uint32_t state = __atomic_load_n(guard, __ATOMIC_ACQUIRE);
+    while((state & guardDone) == 0) {
+      if((state & guardBusy) == 0) {
+        if(__atomic_compare_exchange_n(guard, &state, state | guardBusy, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+          guardInitRegister(guard);
+          return 1;
+        }
+        continue; // state reloaded
+      }
+      // Another task is initializing, or this task is (its initializer reached the same static).
+      if(guardInitializedBySelf(guard)) guardRecursiveInit();
+      configASSERT( !xPortIsInsideInterrupt() );
+      GuardWaiter *w = guardWaitRegister(guard);
+      if(w == nullptr) {
+        vTaskDelay(1); // table full: poll
+      } else {
+        if(__atomic_load_n(guard, __ATOMIC_ACQUIRE) & guardBusy) heapGuardNotifyTake(); // else finished meanwhile
+        guardWaitUnregister(w);
+      }
+      state = __atomic_load_n(guard, __ATOMIC_ACQUIRE);
+    }
+    return 0;
+  }
+  extern "C" void __cxa_guard_release(__guard *g) noexcept {
+    guardFinish((uint32_t *)g, guardDone);
+  }
+  //! Initializer threw: static remains uninitialized, and a waiting task may try again.
+  extern "C" void __cxa_guard_abort(__guard *g) noexcept {
+    guardFinish((uint32_t *)g, 0);
+  }
+} // namespace __cxxabiv1
+#endif
@@ -0,0 +1,186 @@
+/**
+ * \file heap_useNewlib_new.cpp
+ * \brief C++ operator new/delete for use with heap_useNewlib_NXP.c or heap_useNewlib_ST.c.
+ *
+ * \par Overview
+ * Replaces every form of the global operator new and delete (plain, array, nothrow,
+ * sized, and C++17 align_val_t), so C++ allocations go to pvPortMalloc with the same
+ * accounting and malloc-failed hook as the rest of the application, instead of through
+ * libstdc++'s own operator new.
+ *
+ * With configHEAP_NEW_POOL_BLOCKS, small blocks come from fixed size-class pools
+ * (16, 32, 64 and 128 bytes, configHEAP_NEW_POOL_BLOCKS blocks each) held in static storage.
+ * Sized delete goes straight to the block's size class: no header and no heap lock.
+ * Unsized delete recognizes pool blocks by address. Pool blocks are taken and returned
+ * inside a short critical section, and are not counted by the malloc wrappers.
+ * When a class is empty, blocks of that size come from pvPortMalloc.
+ *
+ * Without exceptions (-fno-exceptions), a failed allocation by throwing new calls abort,
+ * as libstdc++'s operator new does.
+ *
+ * \author Dave Nadler
+ * \date 16-Oct-2026
+ *
+ * \copyright
+ * (c) Dave Nadler 2017-2026, All Rights Reserved.
+ * See heap_useNewlib_NXP.c for license terms.
+ */
+
+#include <new>
+#include <cstdlib> // abort
+#include <cstdint>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_useNewlib.h"
+
+extern "C" {
+  void *pvPortMalloc( size_t xSize );
+  void vPortFree( void *pv );
+}
+
+namespace {
+
+#if defined(configHEAP_NEW_POOL_BLOCKS) && configHEAP_NEW_POOL_BLOCKS // DRN size-class pools for new/delete
+  // Class c holds blocks of 16<<c bytes; class storage is laid out in order of increasing size.
+  constexpr int poolClasses = 4;
+  constexpr size_t poolMaxBlockSize = 16u << (poolClasses-1);
+  constexpr size_t poolClassSize(int c) { return 16u << c; }
+  constexpr size_t poolClassBase(int c) { return (size_t)configHEAP_NEW_POOL_BLOCKS * 16u * ((1u << c) - 1); }
+  struct PoolBlock { PoolBlock *next; };
+  struct Pool {
+    PoolBlock *freeList;  // returned blocks
+    uint32_t bumped;      // blocks handed out from storage (never returned to it)
+  };
+  alignas(8) uint8_t poolStorage[poolClassBase(poolClasses)];
+  Pool pools[poolClasses];
+
+  int poolClassOfSize(size_t size) { // size must be <= poolMaxBlockSize
+    return (size <= 16) ? 0 : (int)(32 - __builtin_clz((unsigned)(size-1))) - 4;
+  }
+  bool isPoolBlock(const void *p) {
+    return (const uint8_t *)p >= poolStorage && (const uint8_t *)p < poolStorage + sizeof(poolStorage);
+  }
+  int poolClassOfBlock(const void *p) {
+    size_t offset = (size_t)((const uint8_t *)p - poolStorage);
+    int c = 0;
+    while(c < poolClasses-1 && offset >= poolClassBase(c+1)) c++;
+    return c;
+  }
+  void *poolAllocate(size_t size) {
+    if(size > poolMaxBlockSize) return nullptr;
+    int c = poolClassOfSize(size);
+    Pool &pool = pools[c];
+    UBaseType_t usis = taskENTER_CRITICAL_FROM_ISR(); // usable before scheduler starts and in ISRs
+    PoolBlock *b = pool.freeList;
+    if(b) {
+      pool.freeList = b->next;
+    } else if(pool.bumped < configHEAP_NEW_POOL_BLOCKS) {
+      b = (PoolBlock *)(poolStorage + poolClassBase(c) + pool.bumped++ * poolClassSize(c));
+    }
+    taskEXIT_CRITICAL_FROM_ISR(usis);
+    return b;
+  }
+  void poolFree(void *p, int c) {
+    PoolBlock *b = (PoolBlock *)p;
+    UBaseType_t usis = taskENTER_CRITICAL_FROM_ISR();
+    b->next = pools[c].freeList;
+    pools[c].freeList = b;
+    taskEXIT_CRITICAL_FROM_ISR(usis);
+  }
+#endif
+
+  //! Allocate as operator new does: retry via the new_handler until it gives up. nullptr on failure.
+  void *heapNew(size_t size) {
+    if(size == 0) size = 1; // each new must return a distinct pointer
+    for(;;) {
+      #if defined(configHEAP_NEW_POOL_BLOCKS) && configHEAP_NEW_POOL_BLOCKS
+        void *p = poolAllocate(size);
+        if(p == nullptr) p = pvPortMalloc(size);
+      #else
+        void *p = pvPortMalloc(size);
+      #endif
+      if(p) return p;
+      std::new_handler handler = std::get_new_handler();
+      if(handler == nullptr) return nullptr;
+      handler();
+    }
+  }
+  void *heapNewAligned(size_t size, size_t align) {
+    if(align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) return heapNew(size);
+    if(size == 0) size = 1;
+    for(;;) {
+      void *p = pvPortMallocAligned(align, size);
+      if(p) return p;
+      std::new_handler handler = std::get_new_handler();
+      if(handler == nullptr) return nullptr;
+      handler();
+    }
+  }
+  //! Nothrow forms: a new_handler that throws std::bad_alloc (as the standard's does) means failure.
+  void *heapNewNothrow(size_t size) noexcept {
+    #if defined(__cpp_exceptions)
+      try { return heapNew(size); } catch(const std::bad_alloc &) { return nullptr; }
+    #else
+      return heapNew(size);
+    #endif
+  }
+  void *heapNewAlignedNothrow(size_t size, size_t align) noexcept {
+    #if defined(__cpp_exceptions)
+      try { return heapNewAligned(size, align); } catch(const std::bad_alloc &) { return nullptr; }
+    #else
+      return heapNewAligned(size, align);
+    #endif
+  }
+  void *heapNewOrFail(void *p) {
+    if(p == nullptr) {
+      #if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+      #else
+        abort();
+      #endif
+    }
+    return p;
+  }
+  void heapDelete(void *p) {
+    #if defined(configHEAP_NEW_POOL_BLOCKS) && configHEAP_NEW_POOL_BLOCKS
+      if(isPoolBlock(p)) { poolFree(p, poolClassOfBlock(p)); return; }
+    #endif
+    vPortFree(p);
+  }
+  void heapDeleteSized(void *p, size_t size) {
+    #if defined(configHEAP_NEW_POOL_BLOCKS) && configHEAP_NEW_POOL_BLOCKS
+      if(size <= poolMaxBlockSize && isPoolBlock(p)) { poolFree(p, poolClassOfSize(size ? size : 1)); return; }
+    #else
+      (void)size;
+    #endif
+    vPortFree(p);
+  }
+
+} // namespace
+
+void *operator new(size_t size)                                   { return heapNewOrFail(heapNew(size)); }
+void *operator new[](size_t size)                                 { return heapNewOrFail(heapNew(size)); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept   { return heapNewNothrow(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return heapNewNothrow(size); }
+
+void operator delete(void *p) noexcept                                  { heapDelete(p); }
+void operator delete[](void *p) noexcept                                { heapDelete(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept          { heapDelete(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept        { heapDelete(p); }
+void operator delete(void *p, size_t size) noexcept                     { heapDeleteSized(p, size); }
+void operator delete[](void *p, size_t size) noexcept                   { heapDeleteSized(p, size); }
+
+#if defined(__cpp_aligned_new) // C++17 over-aligned types: blocks never come from the pools
+void *operator new(size_t size, std::align_val_t align)            { return heapNewOrFail(heapNewAligned(size, (size_t)align)); }
+void *operator new[](size_t size, std::align_val_t align)          { return heapNewOrFail(heapNewAligned(size, (size_t)align)); }
+void *operator new(size_t size, std::align_val_t align, const std::nothrow_t &) noexcept   { return heapNewAlignedNothrow(size, (size_t)align); }
+void *operator new[](size_t size, std::align_val_t align, const std::nothrow_t &) noexcept { return heapNewAlignedNothrow(size, (size_t)align); }
+
+void operator delete(void *p, std::align_val_t align) noexcept                            { if((size_t)align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) heapDelete(p); else vPortFree(p); }
+void operator delete[](void *p, std::align_val_t align) noexcept                          { if((size_t)align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) heapDelete(p); else vPortFree(p); }
+void operator delete(void *p, std::align_val_t align, const std::nothrow_t &) noexcept    { if((size_t)align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) heapDelete(p); else vPortFree(p); }
+void operator delete[](void *p, std::align_val_t align, const std::nothrow_t &) noexcept  { if((size_t)align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) heapDelete(p); else vPortFree(p); }
+void operator delete(void *p, size_t size, std::align_val_t align) noexcept   { if((size_t)align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) heapDeleteSized(p, size); else vPortFree(p); }
+void operator delete[](void *p, size_t size, std::align_val_t align) noexcept { if((size_t)align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) heapDeleteSized(p, size); else vPortFree(p); }
+#endif
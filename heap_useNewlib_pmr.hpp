@@ -0,0 +1,103 @@
+/**
+ * \file heap_useNewlib_pmr.hpp
+ * \brief C++17 polymorphic memory resources (std::pmr) for FreeRTOS with heap_useNewlib.
+ *
+ * \par Overview
+ * - freertos_heap_resource: allocates with pvPortMalloc (pvPortMallocAligned for
+ *   over-aligned requests), so pmr containers share the FreeRTOS heap and its accounting.
+ * - freertos_task_pool_resource: std::pmr::unsynchronized_pool_resource for use by a
+ *   single task. Allocations are served from pools of same-sized blocks without any lock;
+ *   only refilling a pool takes the heap lock. Use by any task other than the one that
+ *   constructed it trips configASSERT.
+ * - freertos_arena_resource<N>: std::pmr::monotonic_buffer_resource with N bytes of inline
+ *   storage (on the stack, for request-scoped work), overflowing to the FreeRTOS heap.
+ *   Deallocation does nothing; everything is released when the arena is destroyed.
+ *
+ * \par Example
+ *     freertos_arena_resource<1024> arena;       // per-message scratch memory
+ *     std::pmr::vector<Field> fields{&arena};
+ *     std::pmr::map<int, std::pmr::string> index{&arena};
+ *
+ * \author Dave Nadler
+ * \date 16-Oct-2026
+ *
+ * \copyright
+ * (c) Dave Nadler 2017-2026, All Rights Reserved.
+ * See heap_useNewlib_NXP.c for license terms.
+ */
+
+#ifndef HEAP_USENEWLIB_PMR_HPP
+#define HEAP_USENEWLIB_PMR_HPP
+
+#include <memory_resource>
+#include <new>
+#include <cstdlib> // abort
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_useNewlib.h"
+
+extern "C" {
+  void *pvPortMalloc( size_t xSize );
+  void vPortFree( void *pv );
+}
+
+//! Memory resource over the FreeRTOS heap. All instances are interchangeable; use instance().
+class freertos_heap_resource final : public std::pmr::memory_resource {
+public:
+  static freertos_heap_resource *instance() {
+    static freertos_heap_resource resource;
+    return &resource;
+  }
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    void *p = (alignment <= portBYTE_ALIGNMENT) ? pvPortMalloc(bytes) : pvPortMallocAligned(alignment, bytes);
+    if(p == nullptr) {
+      #if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+      #else
+        abort();
+      #endif
+    }
+    return p;
+  }
+  void do_deallocate(void *p, size_t, size_t) override { vPortFree(p); }
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other; // only instance() exists
+  }
+};
+
+//! Pool resource for a single task: no lock per allocation (see file overview).
+class freertos_task_pool_resource : public std::pmr::unsynchronized_pool_resource {
+public:
+  explicit freertos_task_pool_resource(const std::pmr::pool_options &options = {},
+                                       std::pmr::memory_resource *upstream = freertos_heap_resource::instance())
+    : std::pmr::unsynchronized_pool_resource(options, upstream), owner(xTaskGetCurrentTaskHandle()) {}
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    configASSERT( xTaskGetCurrentTaskHandle() == owner ); // unsynchronized: owner task only
+    return std::pmr::unsynchronized_pool_resource::do_allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    configASSERT( xTaskGetCurrentTaskHandle() == owner );
+    std::pmr::unsynchronized_pool_resource::do_deallocate(p, bytes, alignment);
+  }
+private:
+  TaskHandle_t owner;
+};
+
+namespace heap_useNewlib_detail {
+  // Storage must be constructed before the monotonic_buffer_resource base that uses it.
+  template<size_t N> struct arena_storage { alignas(portBYTE_ALIGNMENT) unsigned char buffer[N]; };
+}
+//! Monotonic arena with N bytes of inline storage, overflowing to upstream (see file overview).
+template<size_t N>
+class freertos_arena_resource : private heap_useNewlib_detail::arena_storage<N>,
+                                public std::pmr::monotonic_buffer_resource {
+  static_assert(N > 0, "use std::pmr::monotonic_buffer_resource for an arena without inline storage");
+public:
+  explicit freertos_arena_resource(std::pmr::memory_resource *upstream = freertos_heap_resource::instance())
+    : std::pmr::monotonic_buffer_resource(this->buffer, N, upstream) {}
+};
+
+#endif // HEAP_USENEWLIB_PMR_HPP
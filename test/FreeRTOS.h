@@ -0,0 +1,35 @@
+/**
+ * \file FreeRTOS.h
+ * \brief Host stand-in for FreeRTOS.h, enough to compile the heap wrappers for tests (see test_realloc_zero.c).
+ */
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define pdFAIL  0
+#define PRIVILEGED_FUNCTION
+#define portBYTE_ALIGNMENT 8
+
+#define configUSE_NEWLIB_REENTRANT 1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 4
+#define configTICK_RATE_HZ 1000
+#define configMAX_TASK_NAME_LEN 16
+#ifndef configASSERT
+  #define configASSERT(x) do { if(!(x)) __builtin_trap(); } while(0)
+#endif
+
+typedef struct { void *p[20]; } StaticQueue_t;
+typedef struct { void *p[11]; } StaticTimer_t;
+typedef struct { void *p[6]; } StaticEventGroup_t;
+typedef struct { void *p[30]; } StaticTask_t;
+
+#endif // FREERTOS_H
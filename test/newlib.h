@@ -0,0 +1,13 @@
+/**
+ * \file newlib.h
+ * \brief Host stand-in for newlib.h: glibc's malloc plays newlib's (both free on realloc(ptr,0) and return NULL).
+ */
+#ifndef NEWLIB_H
+#define NEWLIB_H
+
+#define __NEWLIB__ 4
+#define __NEWLIB_MINOR__ 1
+struct _reent { int _errno; };
+extern struct _reent *_impure_ptr;
+
+#endif // NEWLIB_H
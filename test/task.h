@@ -0,0 +1,26 @@
+/**
+ * \file task.h
+ * \brief Host stand-in for FreeRTOS task.h: declarations only; the test provides a single running task.
+ */
+#ifndef TASK_H
+#define TASK_H
+
+typedef void *TaskHandle_t;
+typedef enum { eNoAction, eSetBits } eNotifyAction;
+#define taskSCHEDULER_NOT_STARTED 1
+#define taskSCHEDULER_RUNNING     2
+#define taskENTER_CRITICAL_FROM_ISR() 0
+#define taskEXIT_CRITICAL_FROM_ISR(x) (void)(x)
+
+void vTaskSuspendAll( void );
+BaseType_t xTaskResumeAll( void );
+BaseType_t xTaskGetSchedulerState( void );
+BaseType_t xPortIsInsideInterrupt( void );
+TaskHandle_t xTaskGetCurrentTaskHandle( void );
+TickType_t xTaskGetTickCount( void );
+void *pvTaskGetThreadLocalStoragePointer( TaskHandle_t xTask, BaseType_t xIndex );
+void vTaskSetThreadLocalStoragePointer( TaskHandle_t xTask, BaseType_t xIndex, void *pvValue );
+char *pcTaskGetName( TaskHandle_t xTask );
+BaseType_t xTaskNotify( TaskHandle_t xTask, uint32_t ulValue, eNotifyAction eAction );
+
+#endif // TASK_H
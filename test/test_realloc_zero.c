@@ -0,0 +1,99 @@
+/**
+ * \file test_realloc_zero.c
+ * \brief Host test: realloc(ptr,0) through the malloc wrappers leaves no accounting behind.
+ *
+ * \par Overview
+ * Includes heap_useNewlib_NXP.c with host stand-ins for FreeRTOS and newlib (this directory),
+ * and calls the wrappers directly; glibc's malloc family stands in for newlib's.
+ * Without a block header, newlib's realloc(ptr,0) frees ptr and returns NULL: HeapBytesInUse
+ * and the leak table must return to their starting values. With task accounting (header),
+ * realloc(ptr,0) returns a block; once freed, task usage must also return to its start.
+ *
+ *   gcc -std=gnu11 -Wall -I test test/test_realloc_zero.c -o test_realloc_zero && ./test_realloc_zero
+ *   gcc -std=gnu11 -Wall -I test -DTEST_TASK_ACCOUNTING test/test_realloc_zero.c -o test_realloc_zero && ./test_realloc_zero
+ *
+ * \author Dave Nadler
+ * \date 16-Oct-2026
+ *
+ * \copyright
+ * (c) Dave Nadler 2017-2026, All Rights Reserved.
+ * See heap_useNewlib_NXP.c for license terms.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#define configHEAP_LEAK_DETECTOR_BLOCKS 64
+#if defined(TEST_TASK_ACCOUNTING)
+  #define configHEAP_TASK_ACCOUNTING 1
+  #define configHEAP_TASK_ACCOUNTING_TLS_INDEX 0
+#endif
+
+// Heap bounds from the "linker"
+__asm__(".bss\n.balign 16\n.globl __HeapBase\n__HeapBase: .skip 65536\n.globl __HeapLimit\n__HeapLimit:\n.text\n");
+
+#include "../heap_useNewlib_NXP.c"
+
+// One task, always running
+static void *testTls[configNUM_THREAD_LOCAL_STORAGE_POINTERS];
+void vTaskSuspendAll( void ) {}
+BaseType_t xTaskResumeAll( void ) { return pdFALSE; }
+BaseType_t xTaskGetSchedulerState( void ) { return taskSCHEDULER_RUNNING; }
+BaseType_t xPortIsInsideInterrupt( void ) { return pdFALSE; }
+TaskHandle_t xTaskGetCurrentTaskHandle( void ) { return (TaskHandle_t)testTls; }
+TickType_t xTaskGetTickCount( void ) { return 0; }
+void *pvTaskGetThreadLocalStoragePointer( TaskHandle_t xTask, BaseType_t xIndex ) { (void)xTask; return testTls[xIndex]; }
+void vTaskSetThreadLocalStoragePointer( TaskHandle_t xTask, BaseType_t xIndex, void *pvValue ) { (void)xTask; testTls[xIndex] = pvValue; }
+char *pcTaskGetName( TaskHandle_t xTask ) { (void)xTask; return "test"; }
+BaseType_t xTaskNotify( TaskHandle_t xTask, uint32_t ulValue, eNotifyAction eAction ) { (void)xTask; (void)ulValue; (void)eAction; return pdPASS; }
+
+// newlib's entry points, as --wrap would provide them
+static struct _reent testReent;
+struct _reent *_impure_ptr = &testReent;
+void *__real_malloc(size_t nbytes) { return malloc(nbytes); }
+void *__real__malloc_r(void *reent, size_t nbytes) { (void)reent; return malloc(nbytes); }
+void __real__free_r(void *reent, void *ptr) { (void)reent; free(ptr); }
+void *__real__realloc_r(void *reent, void *ptr, size_t nbytes) { (void)reent; return realloc(ptr, nbytes); }
+void *__real__memalign_r(void *reent, size_t align, size_t nbytes) { (void)reent; return memalign(align, nbytes); }
+void *__real__calloc_r(void *reent, size_t n, size_t size) { (void)reent; return calloc(n, size); }
+size_t __real__malloc_usable_size_r(void *reent, void *ptr) { (void)reent; return malloc_usable_size(ptr); }
+
+static int failures;
+#define CHECK(cond) do { if(!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } } while(0)
+
+static int leakEntries(void) {
+  int n = 0;
+  for(int i=0; i<configHEAP_LEAK_DETECTOR_BLOCKS; i++) n += (heapLeakTable[i].block != NULL);
+  return n;
+}
+static size_t taskUsage(void) {
+  #if defined(configHEAP_TASK_ACCOUNTING) && configHEAP_TASK_ACCOUNTING
+    return xPortGetTaskHeapUsage(xTaskGetCurrentTaskHandle(), NULL, NULL);
+  #else
+    return 0;
+  #endif
+}
+
+int main(void) {
+  size_t bytesInUse = HeapBytesInUse, usage = taskUsage();
+  int leaks = leakEntries();
+
+  void *p = __wrap__malloc_r(_impure_ptr, 100);
+  CHECK(p != NULL);
+  CHECK(HeapBytesInUse > bytesInUse);
+  CHECK(leakEntries() == leaks+1);
+  void *q = __wrap__realloc_r(_impure_ptr, p, 0);
+  if(HEAP_BLOCK_OVERHEAD == 0) {
+    CHECK(q == NULL); // freed, as newlib does
+  } else {
+    CHECK(q != NULL); // header-only block
+    __wrap__free_r(_impure_ptr, q);
+  }
+  CHECK(HeapBytesInUse == bytesInUse);
+  CHECK(taskUsage() == usage);
+  CHECK(leakEntries() == leaks);
+
+  printf("%s: %s\n", (HEAP_BLOCK_OVERHEAD == 0) ? "no block header" : "block header", failures ? "FAILED" : "passed");
+  return failures ? 1 : 0;
+}